@@ -103,7 +103,7 @@ ENDFUNCTION ()
 
 FUNCTION (casparcg_add_init_statement INIT_FUNCTION_NAME NAME_TO_LOG)
 	SET (CASPARCG_MODULE_INIT_STATEMENTS "${CASPARCG_MODULE_INIT_STATEMENTS}"
-			"	${INIT_FUNCTION_NAME}(dependencies)\;"
+			"	step(L\"module/${NAME_TO_LOG}\", [&] { ${INIT_FUNCTION_NAME}(dependencies)\; })\;"
 			"	CASPAR_LOG(info) << L\"Initialized ${NAME_TO_LOG} module.\"\;"
 			""
 			CACHE INTERNAL ""
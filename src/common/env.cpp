@@ -33,9 +33,12 @@
 #include <boost/property_tree/xml_parser.hpp>
 
 #include <boost/algorithm/string/replace.hpp>
+#include <atomic>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <list>
+#include <mutex>
 
 namespace caspar { namespace env {
 
@@ -45,11 +48,17 @@ std::wstring                 log;
 std::wstring                 ftemplate;
 std::wstring                 data;
 std::wstring                 font;
+std::wstring                 config_file;
 boost::property_tree::wptree pt;
 
+// Callers keep references to the tree returned by properties(), so reloaded trees are never freed, only replaced.
+std::mutex                                       reload_mutex;
+std::list<boost::property_tree::wptree>          reloaded;
+std::atomic<const boost::property_tree::wptree*> current(&pt);
+
 void check_is_configured()
 {
-    if (pt.empty())
+    if (current.load()->empty())
         CASPAR_THROW_EXCEPTION(invalid_operation() << msg_info(L"Enviroment properties has not been configured"));
 }
 
@@ -104,16 +113,22 @@ void ensure_writable(const std::wstring& folder)
     boost::filesystem::remove(test_file, ec);
 }
 
+void read_config(boost::property_tree::wptree& tree)
+{
+    boost::filesystem::wifstream file(initial + L"/" + config_file);
+    boost::property_tree::read_xml(
+        file,
+        tree,
+        boost::property_tree::xml_parser::trim_whitespace | boost::property_tree::xml_parser::no_comments);
+}
+
 void configure(const std::wstring& filename)
 {
     try {
-        initial = clean_path(boost::filesystem::initial_path().wstring());
+        initial     = clean_path(boost::filesystem::initial_path().wstring());
+        config_file = filename;
 
-        boost::filesystem::wifstream file(initial + L"/" + filename);
-        boost::property_tree::read_xml(file,
-                                       pt,
-                                       boost::property_tree::xml_parser::trim_whitespace |
-                                           boost::property_tree::xml_parser::no_comments);
+        read_config(pt);
 
         auto paths = pt.get_child(L"configuration.paths");
         media      = clean_path(paths.get(L"media-path", initial + L"/media/"));
@@ -187,7 +202,27 @@ const std::wstring& version()
 const boost::property_tree::wptree& properties()
 {
     check_is_configured();
-    return pt;
+    return *current.load();
+}
+
+const boost::property_tree::wptree& reload()
+{
+    check_is_configured();
+
+    boost::property_tree::wptree tree;
+    try {
+        read_config(tree);
+        tree.get_child(L"configuration");
+    } catch (...) {
+        CASPAR_LOG(error) << L" ### Invalid configuration file. ###";
+        throw;
+    }
+
+    std::lock_guard<std::mutex> lock(reload_mutex);
+    reloaded.push_back(std::move(tree));
+    current = &reloaded.back();
+
+    return reloaded.back();
 }
 
 void log_configuration_warnings()
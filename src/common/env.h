@@ -39,6 +39,14 @@ const std::wstring& version();
 
 const boost::property_tree::wptree& properties();
 
+/**
+ * Reads the configuration file again and makes it the tree returned by
+ * properties(). Folders are resolved once by configure() and stay unchanged.
+ *
+ * @return The new configuration.
+ */
+const boost::property_tree::wptree& reload();
+
 void log_configuration_warnings();
 
 }} // namespace caspar::env
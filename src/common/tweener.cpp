@@ -55,7 +55,7 @@
 #include <boost/regex.hpp>
 
 #include <algorithm>
-#include <functional>
+#include <cwctype>
 #include <locale>
 #include <string>
 #include <unordered_map>
@@ -63,26 +63,34 @@
 
 namespace caspar {
 
-typedef std::function<double(double, double, double, double)> tweener_t;
+// Up to two optional parameters given after the name, e.g. "easeinelastic:0.5:2".
+struct tween_params
+{
+    double values[2] = {0.0, 0.0};
+    int    count     = 0;
+
+    std::size_t size() const { return static_cast<std::size_t>(count); }
+    double      operator[](std::size_t index) const { return values[index]; }
+};
 
 static const double PI   = std::atan(1.0) * 4.0;
 static const double H_PI = std::atan(1.0) * 2.0;
 
-double ease_none(double t, double b, double c, double d, const std::vector<double>& params) { return c * t / d + b; }
+double ease_none(double t, double b, double c, double d, const tween_params& params) { return c * t / d + b; }
 
-double ease_in_quad(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_quad(double t, double b, double c, double d, const tween_params& params)
 {
     t /= d;
     return c * t * t + b;
 }
 
-double ease_out_quad(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_quad(double t, double b, double c, double d, const tween_params& params)
 {
     t /= d;
     return -c * t * (t - 2) + b;
 }
 
-double ease_in_out_quad(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_out_quad(double t, double b, double c, double d, const tween_params& params)
 {
     t /= d / 2;
     if (t < 1)
@@ -91,7 +99,7 @@ double ease_in_out_quad(double t, double b, double c, double d, const std::vecto
     return -c / 2 * ((t - 1) * (t - 3) - 1) + b;
 }
 
-double ease_out_in_quad(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_in_quad(double t, double b, double c, double d, const tween_params& params)
 {
     if (t < d / 2)
         return ease_out_quad(t * 2, b, c / 2, d, params);
@@ -99,19 +107,19 @@ double ease_out_in_quad(double t, double b, double c, double d, const std::vecto
     return ease_in_quad((t * 2) - d, b + c / 2, c / 2, d, params);
 }
 
-double ease_in_cubic(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_cubic(double t, double b, double c, double d, const tween_params& params)
 {
     t /= d;
     return c * t * t * t + b;
 }
 
-double ease_out_cubic(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_cubic(double t, double b, double c, double d, const tween_params& params)
 {
     t = t / d - 1;
     return c * (t * t * t + 1) + b;
 }
 
-double ease_in_out_cubic(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_out_cubic(double t, double b, double c, double d, const tween_params& params)
 {
     t /= d / 2;
     if (t < 1)
@@ -121,26 +129,26 @@ double ease_in_out_cubic(double t, double b, double c, double d, const std::vect
     return c / 2 * (t * t * t + 2) + b;
 }
 
-double ease_out_in_cubic(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_in_cubic(double t, double b, double c, double d, const tween_params& params)
 {
     if (t < d / 2)
         return ease_out_cubic(t * 2, b, c / 2, d, params);
     return ease_in_cubic((t * 2) - d, b + c / 2, c / 2, d, params);
 }
 
-double ease_in_quart(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_quart(double t, double b, double c, double d, const tween_params& params)
 {
     t /= d;
     return c * t * t * t * t + b;
 }
 
-double ease_out_quart(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_quart(double t, double b, double c, double d, const tween_params& params)
 {
     t = t / d - 1;
     return -c * (t * t * t * t - 1) + b;
 }
 
-double ease_in_out_quart(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_out_quart(double t, double b, double c, double d, const tween_params& params)
 {
     t /= d / 2;
     if (t < 1)
@@ -150,7 +158,7 @@ double ease_in_out_quart(double t, double b, double c, double d, const std::vect
     return -c / 2 * (t * t * t * t - 2) + b;
 }
 
-double ease_out_in_quart(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_in_quart(double t, double b, double c, double d, const tween_params& params)
 {
     if (t < d / 2)
         return ease_out_quart(t * 2, b, c / 2, d, params);
@@ -158,19 +166,19 @@ double ease_out_in_quart(double t, double b, double c, double d, const std::vect
     return ease_in_quart((t * 2) - d, b + c / 2, c / 2, d, params);
 }
 
-double ease_in_quint(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_quint(double t, double b, double c, double d, const tween_params& params)
 {
     t /= d;
     return c * t * t * t * t * t + b;
 }
 
-double ease_out_quint(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_quint(double t, double b, double c, double d, const tween_params& params)
 {
     t = t / d - 1;
     return c * (t * t * t * t * t + 1) + b;
 }
 
-double ease_in_out_quint(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_out_quint(double t, double b, double c, double d, const tween_params& params)
 {
     t /= d / 2;
     if (t < 1)
@@ -180,7 +188,7 @@ double ease_in_out_quint(double t, double b, double c, double d, const std::vect
     return c / 2 * (t * t * t * t * t + 2) + b;
 }
 
-double ease_out_in_quint(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_in_quint(double t, double b, double c, double d, const tween_params& params)
 {
     if (t < d / 2)
         return ease_out_quint(t * 2, b, c / 2, d, params);
@@ -188,22 +196,22 @@ double ease_out_in_quint(double t, double b, double c, double d, const std::vect
     return ease_in_quint((t * 2) - d, b + c / 2, c / 2, d, params);
 }
 
-double ease_in_sine(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_sine(double t, double b, double c, double d, const tween_params& params)
 {
     return -c * std::cos(t / d * (PI / 2)) + c + b;
 }
 
-double ease_out_sine(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_sine(double t, double b, double c, double d, const tween_params& params)
 {
     return c * std::sin(t / d * (PI / 2)) + b;
 }
 
-double ease_in_out_sine(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_out_sine(double t, double b, double c, double d, const tween_params& params)
 {
     return -c / 2 * (std::cos(PI * t / d) - 1) + b;
 }
 
-double ease_out_in_sine(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_in_sine(double t, double b, double c, double d, const tween_params& params)
 {
     if (t < d / 2)
         return ease_out_sine(t * 2, b, c / 2, d, params);
@@ -211,17 +219,17 @@ double ease_out_in_sine(double t, double b, double c, double d, const std::vecto
     return ease_in_sine((t * 2) - d, b + c / 2, c / 2, d, params);
 }
 
-double ease_in_expo(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_expo(double t, double b, double c, double d, const tween_params& params)
 {
     return (t == 0) ? b : c * std::pow(2, 10 * (t / d - 1)) + b - c * 0.001;
 }
 
-double ease_out_expo(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_expo(double t, double b, double c, double d, const tween_params& params)
 {
     return (t == d) ? b + c : c * 1.001 * (-std::pow(2, -10 * t / d) + 1) + b;
 }
 
-double ease_in_out_expo(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_out_expo(double t, double b, double c, double d, const tween_params& params)
 {
     if (t == 0)
         return b;
@@ -234,7 +242,7 @@ double ease_in_out_expo(double t, double b, double c, double d, const std::vecto
     return c / 2 * 1.0005 * (-std::pow(2, -10 * (t - 1)) + 2) + b;
 }
 
-double ease_out_in_expo(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_in_expo(double t, double b, double c, double d, const tween_params& params)
 {
     if (t < d / 2)
         return ease_out_expo(t * 2, b, c / 2, d, params);
@@ -242,19 +250,19 @@ double ease_out_in_expo(double t, double b, double c, double d, const std::vecto
     return ease_in_expo((t * 2) - d, b + c / 2, c / 2, d, params);
 }
 
-double ease_in_circ(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_circ(double t, double b, double c, double d, const tween_params& params)
 {
     t /= d;
     return -c * (std::sqrt(1 - t * t) - 1) + b;
 }
 
-double ease_out_circ(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_circ(double t, double b, double c, double d, const tween_params& params)
 {
     t = t / d - 1;
     return c * std::sqrt(1 - t * t) + b;
 }
 
-double ease_in_out_circ(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_out_circ(double t, double b, double c, double d, const tween_params& params)
 {
     t /= d / 2;
     if (t < 1)
@@ -264,14 +272,14 @@ double ease_in_out_circ(double t, double b, double c, double d, const std::vecto
     return c / 2 * (std::sqrt(1 - t * t) + 1) + b;
 }
 
-double ease_out_in_circ(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_in_circ(double t, double b, double c, double d, const tween_params& params)
 {
     if (t < d / 2)
         return ease_out_circ(t * 2, b, c / 2, d, params);
     return ease_in_circ((t * 2) - d, b + c / 2, c / 2, d, params);
 }
 
-double ease_in_elastic(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_elastic(double t, double b, double c, double d, const tween_params& params)
 {
     if (t == 0)
         return b;
@@ -294,7 +302,7 @@ double ease_in_elastic(double t, double b, double c, double d, const std::vector
     return -(a * std::pow(2, 10 * t) * std::sin((t * d - s) * (2 * PI) / p)) + b;
 }
 
-double ease_out_elastic(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_elastic(double t, double b, double c, double d, const tween_params& params)
 {
     if (t == 0)
         return b;
@@ -316,7 +324,7 @@ double ease_out_elastic(double t, double b, double c, double d, const std::vecto
     return (a * std::pow(2, -10 * t) * std::sin((t * d - s) * (2 * PI) / p) + c + b);
 }
 
-double ease_in_out_elastic(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_out_elastic(double t, double b, double c, double d, const tween_params& params)
 {
     if (t == 0)
         return b;
@@ -342,14 +350,14 @@ double ease_in_out_elastic(double t, double b, double c, double d, const std::ve
     }
 }
 
-double ease_out_in_elastic(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_in_elastic(double t, double b, double c, double d, const tween_params& params)
 {
     if (t < d / 2)
         return ease_out_elastic(t * 2, b, c / 2, d, params);
     return ease_in_elastic((t * 2) - d, b + c / 2, c / 2, d, params);
 }
 
-double ease_in_back(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_back(double t, double b, double c, double d, const tween_params& params)
 {
     // var s:Number = !Boolean(p_params) || isNaN(p_params.overshoot) ? 1.70158 : p_params.overshoot;
     double s = params.size() > 0 ? params[0] : 1.70158;
@@ -357,7 +365,7 @@ double ease_in_back(double t, double b, double c, double d, const std::vector<do
     return c * t * t * ((s + 1) * t - s) + b;
 }
 
-double ease_out_back(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_back(double t, double b, double c, double d, const tween_params& params)
 {
     // var s:Number = !Boolean(p_params) || isNaN(p_params.overshoot) ? 1.70158 : p_params.overshoot;
     double s = params.size() > 0 ? params[0] : 1.70158;
@@ -365,7 +373,7 @@ double ease_out_back(double t, double b, double c, double d, const std::vector<d
     return c * (t * t * ((s + 1) * t + s) + 1) + b;
 }
 
-double ease_in_out_back(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_out_back(double t, double b, double c, double d, const tween_params& params)
 {
     // var s:Number = !Boolean(p_params) || isNaN(p_params.overshoot) ? 1.70158 : p_params.overshoot;
     double s = params.size() > 0 ? params[0] : 1.70158;
@@ -377,14 +385,14 @@ double ease_in_out_back(double t, double b, double c, double d, const std::vecto
     return c / 2 * (t * t * ((s + 1) * t + s) + 2) + b;
 }
 
-double ease_out_int_back(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_int_back(double t, double b, double c, double d, const tween_params& params)
 {
     if (t < d / 2)
         return ease_out_back(t * 2, b, c / 2, d, params);
     return ease_in_back((t * 2) - d, b + c / 2, c / 2, d, params);
 }
 
-double ease_out_bounce(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_bounce(double t, double b, double c, double d, const tween_params& params)
 {
     t /= d;
     if (t < (1 / 2.75))
@@ -401,12 +409,12 @@ double ease_out_bounce(double t, double b, double c, double d, const std::vector
     }
 }
 
-double ease_in_bounce(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_bounce(double t, double b, double c, double d, const tween_params& params)
 {
     return c - ease_out_bounce(d - t, 0, c, d, params) + b;
 }
 
-double ease_in_out_bounce(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_in_out_bounce(double t, double b, double c, double d, const tween_params& params)
 {
     if (t < d / 2)
         return ease_in_bounce(t * 2, 0, c, d, params) * .5 + b;
@@ -414,99 +422,239 @@ double ease_in_out_bounce(double t, double b, double c, double d, const std::vec
         return ease_out_bounce(t * 2 - d, 0, c, d, params) * .5 + c * .5 + b;
 }
 
-double ease_out_in_bounce(double t, double b, double c, double d, const std::vector<double>& params)
+double ease_out_in_bounce(double t, double b, double c, double d, const tween_params& params)
 {
     if (t < d / 2)
         return ease_out_bounce(t * 2, b, c / 2, d, params);
     return ease_in_bounce((t * 2) - d, b + c / 2, c / 2, d, params);
 }
 
-typedef std::function<double(double, double, double, double, const std::vector<double>&)> tween_t;
-
-const std::unordered_map<std::wstring, tween_t>& get_tweens()
-{
-    static const std::unordered_map<std::wstring, tween_t> tweens = {{L"", ease_none},
-                                                                     {L"linear", ease_none},
-                                                                     {L"easenone", ease_none},
-                                                                     {L"easeinquad", ease_in_quad},
-                                                                     {L"easeoutquad", ease_out_quad},
-                                                                     {L"easeinoutquad", ease_in_out_quad},
-                                                                     {L"easeoutinquad", ease_out_in_quad},
-                                                                     {L"easeincubic", ease_in_cubic},
-                                                                     {L"easeoutcubic", ease_out_cubic},
-                                                                     {L"easeinoutcubic", ease_in_out_cubic},
-                                                                     {L"easeoutincubic", ease_out_in_cubic},
-                                                                     {L"easeinquart", ease_in_quart},
-                                                                     {L"easeoutquart", ease_out_quart},
-                                                                     {L"easeinoutquart", ease_in_out_quart},
-                                                                     {L"easeoutinquart", ease_out_in_quart},
-                                                                     {L"easeinquint", ease_in_quint},
-                                                                     {L"easeoutquint", ease_out_quint},
-                                                                     {L"easeinoutquint", ease_in_out_quint},
-                                                                     {L"easeoutinquint", ease_out_in_quint},
-                                                                     {L"easeinsine", ease_in_sine},
-                                                                     {L"easeoutsine", ease_out_sine},
-                                                                     {L"easeinoutsine", ease_in_out_sine},
-                                                                     {L"easeoutinsine", ease_out_in_sine},
-                                                                     {L"easeinexpo", ease_in_expo},
-                                                                     {L"easeoutexpo", ease_out_expo},
-                                                                     {L"easeinoutexpo", ease_in_out_expo},
-                                                                     {L"easeoutinexpo", ease_out_in_expo},
-                                                                     {L"easeincirc", ease_in_circ},
-                                                                     {L"easeoutcirc", ease_out_circ},
-                                                                     {L"easeinoutcirc", ease_in_out_circ},
-                                                                     {L"easeoutincirc", ease_out_in_circ},
-                                                                     {L"easeinelastic", ease_in_elastic},
-                                                                     {L"easeoutelastic", ease_out_elastic},
-                                                                     {L"easeinoutelastic", ease_in_out_elastic},
-                                                                     {L"easeoutinelastic", ease_out_in_elastic},
-                                                                     {L"easeinback", ease_in_back},
-                                                                     {L"easeoutback", ease_out_back},
-                                                                     {L"easeinoutback", ease_in_out_back},
-                                                                     {L"easeoutintback", ease_out_int_back},
-                                                                     {L"easeoutbounce", ease_out_bounce},
-                                                                     {L"easeinbounce", ease_in_bounce},
-                                                                     {L"easeinoutbounce", ease_in_out_bounce},
-                                                                     {L"easeoutinbounce", ease_out_in_bounce}};
+enum class tweener::easing
+{
+    none,
+    in_quad,
+    out_quad,
+    in_out_quad,
+    out_in_quad,
+    in_cubic,
+    out_cubic,
+    in_out_cubic,
+    out_in_cubic,
+    in_quart,
+    out_quart,
+    in_out_quart,
+    out_in_quart,
+    in_quint,
+    out_quint,
+    in_out_quint,
+    out_in_quint,
+    in_sine,
+    out_sine,
+    in_out_sine,
+    out_in_sine,
+    in_expo,
+    out_expo,
+    in_out_expo,
+    out_in_expo,
+    in_circ,
+    out_circ,
+    in_out_circ,
+    out_in_circ,
+    in_elastic,
+    out_elastic,
+    in_out_elastic,
+    out_in_elastic,
+    in_back,
+    out_back,
+    in_out_back,
+    out_in_back,
+    out_bounce,
+    in_bounce,
+    in_out_bounce,
+    out_in_bounce
+};
+
+const std::unordered_map<std::wstring, tweener::easing>& get_tweens()
+{
+    typedef tweener::easing e;
+
+    static const std::unordered_map<std::wstring, tweener::easing> tweens = {{L"", e::none},
+                                                                             {L"linear", e::none},
+                                                                             {L"easenone", e::none},
+                                                                             {L"easeinquad", e::in_quad},
+                                                                             {L"easeoutquad", e::out_quad},
+                                                                             {L"easeinoutquad", e::in_out_quad},
+                                                                             {L"easeoutinquad", e::out_in_quad},
+                                                                             {L"easeincubic", e::in_cubic},
+                                                                             {L"easeoutcubic", e::out_cubic},
+                                                                             {L"easeinoutcubic", e::in_out_cubic},
+                                                                             {L"easeoutincubic", e::out_in_cubic},
+                                                                             {L"easeinquart", e::in_quart},
+                                                                             {L"easeoutquart", e::out_quart},
+                                                                             {L"easeinoutquart", e::in_out_quart},
+                                                                             {L"easeoutinquart", e::out_in_quart},
+                                                                             {L"easeinquint", e::in_quint},
+                                                                             {L"easeoutquint", e::out_quint},
+                                                                             {L"easeinoutquint", e::in_out_quint},
+                                                                             {L"easeoutinquint", e::out_in_quint},
+                                                                             {L"easeinsine", e::in_sine},
+                                                                             {L"easeoutsine", e::out_sine},
+                                                                             {L"easeinoutsine", e::in_out_sine},
+                                                                             {L"easeoutinsine", e::out_in_sine},
+                                                                             {L"easeinexpo", e::in_expo},
+                                                                             {L"easeoutexpo", e::out_expo},
+                                                                             {L"easeinoutexpo", e::in_out_expo},
+                                                                             {L"easeoutinexpo", e::out_in_expo},
+                                                                             {L"easeincirc", e::in_circ},
+                                                                             {L"easeoutcirc", e::out_circ},
+                                                                             {L"easeinoutcirc", e::in_out_circ},
+                                                                             {L"easeoutincirc", e::out_in_circ},
+                                                                             {L"easeinelastic", e::in_elastic},
+                                                                             {L"easeoutelastic", e::out_elastic},
+                                                                             {L"easeinoutelastic", e::in_out_elastic},
+                                                                             {L"easeoutinelastic", e::out_in_elastic},
+                                                                             {L"easeinback", e::in_back},
+                                                                             {L"easeoutback", e::out_back},
+                                                                             {L"easeinoutback", e::in_out_back},
+                                                                             {L"easeoutintback", e::out_in_back},
+                                                                             {L"easeoutbounce", e::out_bounce},
+                                                                             {L"easeinbounce", e::in_bounce},
+                                                                             {L"easeinoutbounce", e::in_out_bounce},
+                                                                             {L"easeoutinbounce", e::out_in_bounce}};
 
     return tweens;
 }
 
-tweener_t get_tweener(std::wstring name)
-{
-    std::transform(name.begin(), name.end(), name.begin(), std::towlower);
+double ease(tweener::easing easing, double t, double b, double c, double d, const tween_params& params)
+{
+    typedef tweener::easing e;
+
+    switch (easing) {
+        case e::none:
+            return ease_none(t, b, c, d, params);
+        case e::in_quad:
+            return ease_in_quad(t, b, c, d, params);
+        case e::out_quad:
+            return ease_out_quad(t, b, c, d, params);
+        case e::in_out_quad:
+            return ease_in_out_quad(t, b, c, d, params);
+        case e::out_in_quad:
+            return ease_out_in_quad(t, b, c, d, params);
+        case e::in_cubic:
+            return ease_in_cubic(t, b, c, d, params);
+        case e::out_cubic:
+            return ease_out_cubic(t, b, c, d, params);
+        case e::in_out_cubic:
+            return ease_in_out_cubic(t, b, c, d, params);
+        case e::out_in_cubic:
+            return ease_out_in_cubic(t, b, c, d, params);
+        case e::in_quart:
+            return ease_in_quart(t, b, c, d, params);
+        case e::out_quart:
+            return ease_out_quart(t, b, c, d, params);
+        case e::in_out_quart:
+            return ease_in_out_quart(t, b, c, d, params);
+        case e::out_in_quart:
+            return ease_out_in_quart(t, b, c, d, params);
+        case e::in_quint:
+            return ease_in_quint(t, b, c, d, params);
+        case e::out_quint:
+            return ease_out_quint(t, b, c, d, params);
+        case e::in_out_quint:
+            return ease_in_out_quint(t, b, c, d, params);
+        case e::out_in_quint:
+            return ease_out_in_quint(t, b, c, d, params);
+        case e::in_sine:
+            return ease_in_sine(t, b, c, d, params);
+        case e::out_sine:
+            return ease_out_sine(t, b, c, d, params);
+        case e::in_out_sine:
+            return ease_in_out_sine(t, b, c, d, params);
+        case e::out_in_sine:
+            return ease_out_in_sine(t, b, c, d, params);
+        case e::in_expo:
+            return ease_in_expo(t, b, c, d, params);
+        case e::out_expo:
+            return ease_out_expo(t, b, c, d, params);
+        case e::in_out_expo:
+            return ease_in_out_expo(t, b, c, d, params);
+        case e::out_in_expo:
+            return ease_out_in_expo(t, b, c, d, params);
+        case e::in_circ:
+            return ease_in_circ(t, b, c, d, params);
+        case e::out_circ:
+            return ease_out_circ(t, b, c, d, params);
+        case e::in_out_circ:
+            return ease_in_out_circ(t, b, c, d, params);
+        case e::out_in_circ:
+            return ease_out_in_circ(t, b, c, d, params);
+        case e::in_elastic:
+            return ease_in_elastic(t, b, c, d, params);
+        case e::out_elastic:
+            return ease_out_elastic(t, b, c, d, params);
+        case e::in_out_elastic:
+            return ease_in_out_elastic(t, b, c, d, params);
+        case e::out_in_elastic:
+            return ease_out_in_elastic(t, b, c, d, params);
+        case e::in_back:
+            return ease_in_back(t, b, c, d, params);
+        case e::out_back:
+            return ease_out_back(t, b, c, d, params);
+        case e::in_out_back:
+            return ease_in_out_back(t, b, c, d, params);
+        case e::out_in_back:
+            return ease_out_int_back(t, b, c, d, params);
+        case e::out_bounce:
+            return ease_out_bounce(t, b, c, d, params);
+        case e::in_bounce:
+            return ease_in_bounce(t, b, c, d, params);
+        case e::in_out_bounce:
+            return ease_in_out_bounce(t, b, c, d, params);
+        case e::out_in_bounce:
+            return ease_out_in_bounce(t, b, c, d, params);
+    }
 
-    if (name == L"linear")
-        return [](double t, double b, double c, double d) { return ease_none(t, b, c, d, std::vector<double>()); };
+    return ease_none(t, b, c, d, params);
+}
 
-    std::vector<double> params;
+tweener::tweener(const std::wstring& name)
+    : name_(name)
+{
+    auto lower_name = name;
+    std::transform(lower_name.begin(), lower_name.end(), lower_name.begin(), std::towlower);
 
     static const boost::wregex expr(
         LR"((?<NAME>\w*)(:(?<V0>\d+\.?\d?))?(:(?<V1>\d+\.?\d?))?)"); // boost::regex has no repeated captures?
     boost::wsmatch what;
-    if (boost::regex_match(name, what, expr)) {
-        name = what["NAME"].str();
+    if (boost::regex_match(lower_name, what, expr)) {
+        lower_name = what["NAME"].str();
         if (what["V0"].matched)
-            params.push_back(boost::lexical_cast<double>(what["V0"].str()));
+            params_[nb_params_++] = boost::lexical_cast<double>(what["V0"].str());
         if (what["V1"].matched)
-            params.push_back(boost::lexical_cast<double>(what["V1"].str()));
+            params_[nb_params_++] = boost::lexical_cast<double>(what["V1"].str());
     }
 
-    auto it = get_tweens().find(name);
+    auto it = get_tweens().find(lower_name);
     if (it == get_tweens().end())
-        CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Could not find tween " + name));
+        CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Could not find tween " + lower_name));
 
-    auto tween = it->second;
-    return [=](double t, double b, double c, double d) { return tween(t, b, c, d, params); };
-};
+    easing_ = it->second;
 
-tweener::tweener(const std::wstring& name)
-    : func_(get_tweener(name))
-    , name_(name)
-{
+    // An explicit elastic amplitude makes the curve depend on the distance travelled.
+    auto is_elastic = easing_ == easing::in_elastic || easing_ == easing::out_elastic ||
+                      easing_ == easing::in_out_elastic || easing_ == easing::out_in_elastic;
+    has_weight_ = !(is_elastic && nb_params_ > 1);
 }
 
-double tweener::operator()(double t, double b, double c, double d) const { return func_(t, b, c, d); }
+double tweener::operator()(double t, double b, double c, double d) const
+{
+    tween_params params;
+    params.values[0] = params_[0];
+    params.values[1] = params_[1];
+    params.count     = nb_params_;
+
+    return ease(easing_, t, b, c, d, params);
+}
 
 bool tweener::operator==(const tweener& other) const { return name_ == other.name_; }
 
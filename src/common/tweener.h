@@ -21,7 +21,6 @@
 
 #pragma once
 
-#include <functional>
 #include <string>
 #include <vector>
 
@@ -39,6 +38,8 @@ namespace caspar {
 class tweener
 {
   public:
+    enum class easing;
+
     /**
      * Constructor.
      *
@@ -71,12 +72,35 @@ class tweener
      */
     double operator()(double t, double b, double c, double d) const;
 
+    /**
+     * Calculate the eased progress at a timepoint, i.e. the w for which
+     * operator()(t, b, c, d) == b + c * w. Evaluating it once and applying it
+     * to many values is much cheaper than tweening each value.
+     *
+     * Only valid if has_weight().
+     */
+    double weight(double t, double d) const { return (*this)(t, 0.0, 1.0, d); }
+
+    /**
+     * @return false for elastic tweens with an explicit amplitude, whose curve
+     *         depends on the distance travelled.
+     */
+    bool has_weight() const { return has_weight_; }
+
+    /**
+     * @return The name the tweener was created from, including any parameters.
+     */
+    const std::wstring& name() const { return name_; }
+
     bool operator==(const tweener& other) const;
     bool operator!=(const tweener& other) const;
 
   private:
-    std::function<double(double, double, double, double)> func_;
-    std::wstring                                          name_;
+    easing       easing_;
+    double       params_[2]  = {0.0, 0.0};
+    int          nb_params_  = 0;
+    bool         has_weight_ = true;
+    std::wstring name_;
 };
 
 } // namespace caspar
@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+
+
+#include "StdAfx.h"
+
+#include "channel_clock.h"
+
+#include "monitor/system_state.h"
+
+#include <common/diagnostics/graph.h>
+#include <common/env.h>
+#include <common/log.h>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace caspar { namespace core {
+
+namespace {
+
+typedef std::chrono::steady_clock clock_t;
+
+// Time of tick n of a clock running at framerate, in integer nanoseconds: n * den / num seconds. Whole seconds are
+// split off first so that the arithmetic neither rounds nor overflows however long the channel runs.
+std::chrono::nanoseconds tick_offset(std::int64_t n, const boost::rational<int>& framerate)
+{
+    auto num = static_cast<std::int64_t>(framerate.numerator());
+    auto den = static_cast<std::int64_t>(framerate.denominator());
+    return std::chrono::seconds(n / num * den) + std::chrono::nanoseconds(n % num * den * 1000000000LL / num);
+}
+
+// The first tick at or after elapsed.
+std::int64_t tick_at(std::chrono::nanoseconds elapsed, const boost::rational<int>& framerate)
+{
+    if (elapsed.count() <= 0) {
+        return 0;
+    }
+
+    auto n = static_cast<std::int64_t>(std::ceil(static_cast<double>(elapsed.count()) * framerate.numerator() /
+                                                 (framerate.denominator() * 1000000000.0)));
+    while (tick_offset(n, framerate) < elapsed) {
+        ++n;
+    }
+    while (n > 0 && tick_offset(n - 1, framerate) >= elapsed) {
+        --n;
+    }
+    return n;
+}
+
+// The schedule followed by one channel, or shared by all genlocked channels.
+struct timeline
+{
+    std::mutex                  mutex;
+    bool                        started = false;
+    clock_t::time_point         epoch;
+    int                         source = 0; // Channel whose consumer clocks the timeline, 0 if none.
+    std::map<int, std::int64_t> phase_errors;
+
+    core::monitor::state state()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        core::monitor::state state;
+        state["source"] = source;
+
+        if (!phase_errors.empty()) {
+            auto minmax = std::minmax_element(
+                phase_errors.begin(), phase_errors.end(), [](auto& a, auto& b) { return a.second < b.second; });
+            state["phase-error/spread"] = minmax.second->second - minmax.first->second;
+        }
+        for (auto& error : phase_errors) {
+            state["channels"][error.first]["phase-error"] = error.second;
+        }
+        return state;
+    }
+};
+
+std::shared_ptr<timeline> genlock_timeline()
+{
+    static std::shared_ptr<timeline> instance = [] {
+        auto                    result = std::make_shared<timeline>();
+        std::weak_ptr<timeline> weak   = result;
+        monitor::register_system_state("genlock", [weak] {
+            auto timeline = weak.lock();
+            return timeline ? timeline->state() : monitor::state();
+        });
+        return result;
+    }();
+    return instance;
+}
+
+} // namespace
+
+struct channel_clock::impl
+{
+    // Upper bounds in microseconds of the jitter histogram buckets, the last bucket takes the rest.
+    static constexpr std::array<std::int64_t, 7> buckets = {{50, 100, 250, 500, 1000, 2000, 5000}};
+
+    spl::shared_ptr<diagnostics::graph> graph_;
+    const int                           channel_index_;
+    const std::chrono::nanoseconds      spin_;
+    const int                           catch_up_;
+
+    std::mutex               mode_mutex_;
+    bool                     genlock_ = false;
+    std::chrono::nanoseconds phase_{0};
+    bool                     offline_ = false;
+
+    std::shared_ptr<timeline> timeline_  = std::make_shared<timeline>();
+    bool                      joined_    = false;
+    bool                      genlocked_ = false;
+    std::chrono::nanoseconds  joined_phase_{0};
+    boost::rational<int>      framerate_;
+    std::int64_t              count_ = 0;
+
+    std::int64_t                                 ticks_       = 0;
+    std::int64_t                                 late_        = 0;
+    std::int64_t                                 skipped_     = 0;
+    std::int64_t                                 last_jitter_ = 0;
+    std::int64_t                                 max_jitter_  = 0;
+    std::array<std::int64_t, buckets.size() + 1> histogram_   = {};
+
+    bool                rendering_ = false;
+    clock_t::time_point render_start_;
+    clock_t::time_point render_end_;
+    std::int64_t        render_frames_ = 0;
+    double              render_time_   = 0.0; // Seconds of output rendered.
+    clock_t::time_point window_start_;
+    std::int64_t        window_frames_ = 0;
+    double              render_fps_    = 0.0;
+
+    impl(spl::shared_ptr<diagnostics::graph> graph, int channel_index)
+        : graph_(std::move(graph))
+        , channel_index_(channel_index)
+        , spin_(std::chrono::microseconds(std::max(0, env::properties().get(L"configuration.clock.spin", 1000))))
+        , catch_up_(std::max(0, env::properties().get(L"configuration.clock.catch-up", 2)))
+    {
+        graph_->set_color("skipped-tick", diagnostics::color(0.6f, 0.3f, 0.9f));
+    }
+
+    ~impl() { leave(); }
+
+    void genlock(bool enabled, std::chrono::nanoseconds phase)
+    {
+        std::lock_guard<std::mutex> lock(mode_mutex_);
+        genlock_ = enabled;
+        phase_   = std::max(std::chrono::nanoseconds(0), phase);
+    }
+
+    void offline(bool enabled)
+    {
+        std::lock_guard<std::mutex> lock(mode_mutex_);
+        offline_ = enabled;
+    }
+
+    void leave()
+    {
+        std::lock_guard<std::mutex> lock(timeline_->mutex);
+        timeline_->phase_errors.erase(channel_index_);
+        if (timeline_->source == channel_index_) {
+            timeline_->source = 0;
+        }
+        joined_ = false;
+    }
+
+    void tick(const boost::rational<int>& framerate, bool external)
+    {
+        bool offline;
+        {
+            std::lock_guard<std::mutex> lock(mode_mutex_);
+            if (genlock_ != genlocked_ || phase_ != joined_phase_) {
+                leave();
+                timeline_     = genlock_ ? genlock_timeline() : std::make_shared<timeline>();
+                genlocked_    = genlock_;
+                joined_phase_ = phase_;
+            }
+            offline = offline_;
+        }
+
+        if (offline != rendering_) {
+            if (offline) {
+                leave();
+                begin_render();
+            } else {
+                end_render();
+            }
+        }
+
+        if (rendering_) {
+            render(framerate);
+            return;
+        }
+
+        if (framerate.numerator() <= 0) {
+            leave();
+            return;
+        }
+
+        auto                         now = clock_t::now();
+        std::unique_lock<std::mutex> lock(timeline_->mutex);
+
+        if (!timeline_->started) {
+            timeline_->started = true;
+            timeline_->epoch   = now;
+        }
+
+        auto elapsed = [&](clock_t::time_point time) { return time - timeline_->epoch - joined_phase_; };
+
+        if (!joined_ || framerate != framerate_) {
+            joined_    = true;
+            framerate_ = framerate;
+            count_     = tick_at(elapsed(now), framerate_);
+        } else {
+            count_ += 1;
+        }
+
+        auto deadline = timeline_->epoch + joined_phase_ + tick_offset(count_, framerate_);
+
+        // A channel paced by its own consumer cannot wait for the timeline. The first one becomes its source instead
+        // and pulls the epoch towards its own ticks, so that the other channels follow the external clock.
+        if (external) {
+            if (timeline_->source == 0) {
+                timeline_->source = channel_index_;
+            }
+
+            auto error = now - deadline;
+            if (std::abs(error.count()) > tick_offset(1, framerate_).count()) {
+                if (timeline_->source == channel_index_) {
+                    timeline_->epoch += error;
+                } else {
+                    count_ = tick_at(elapsed(now), framerate_);
+                }
+            } else if (timeline_->source == channel_index_) {
+                timeline_->epoch += error / 8;
+            }
+
+            record(std::chrono::duration_cast<std::chrono::microseconds>(error).count());
+            return;
+        }
+
+        if (timeline_->source == channel_index_) {
+            timeline_->source = 0;
+        }
+
+        if (now > deadline + tick_offset(catch_up_, framerate_)) {
+            auto count = tick_at(elapsed(now), framerate_);
+            skipped_ += count - count_;
+            count_   = count;
+            deadline = timeline_->epoch + joined_phase_ + tick_offset(count_, framerate_);
+            graph_->set_tag(diagnostics::tag_severity::WARNING, "skipped-tick");
+        }
+
+        lock.unlock();
+
+        if (now < deadline) {
+            if (deadline - now > spin_) {
+                std::this_thread::sleep_until(deadline - spin_);
+            }
+            while ((now = clock_t::now()) < deadline) {
+                std::this_thread::yield();
+            }
+        } else {
+            late_ += 1;
+        }
+
+        lock.lock();
+        record(std::chrono::duration_cast<std::chrono::microseconds>(now - deadline).count());
+    }
+
+    // Called with the timeline locked.
+    void record(std::int64_t jitter)
+    {
+        timeline_->phase_errors[channel_index_] = jitter;
+
+        ticks_ += 1;
+        last_jitter_ = jitter;
+        max_jitter_  = std::max(max_jitter_, jitter);
+
+        auto it = std::lower_bound(buckets.begin(), buckets.end(), std::abs(jitter));
+        histogram_[it - buckets.begin()] += 1;
+    }
+
+    void begin_render()
+    {
+        rendering_     = true;
+        render_start_  = clock_t::now();
+        window_start_  = render_start_;
+        render_frames_ = 0;
+        render_time_   = 0.0;
+        window_frames_ = 0;
+        render_fps_    = 0.0;
+
+        CASPAR_LOG(info) << print() << L" Rendering offline.";
+    }
+
+    // Counts a tick of an offline channel. The rate is measured over windows of about a second.
+    void render(const boost::rational<int>& framerate)
+    {
+        auto now = clock_t::now();
+
+        render_frames_ += 1;
+        window_frames_ += 1;
+        if (framerate.numerator() > 0) {
+            render_time_ += static_cast<double>(framerate.denominator()) / framerate.numerator();
+        }
+
+        if (now - window_start_ >= std::chrono::seconds(1)) {
+            render_fps_    = window_frames_ / seconds(now - window_start_);
+            window_start_  = now;
+            window_frames_ = 0;
+        }
+    }
+
+    void end_render()
+    {
+        rendering_  = false;
+        render_end_ = clock_t::now();
+
+        auto elapsed = seconds(render_end_ - render_start_);
+        CASPAR_LOG(info) << print() << L" Rendered " << render_frames_ << L" frames (" << render_time_ << L" s) in "
+                         << elapsed << L" s, " << (elapsed > 0.0 ? render_frames_ / elapsed : 0.0) << L" fps.";
+    }
+
+    void reset() { leave(); }
+
+    core::monitor::state state() const
+    {
+        core::monitor::state state;
+        state["genlock"]     = genlocked_;
+        state["ticks"]       = ticks_;
+        state["late"]        = late_;
+        state["skipped"]     = skipped_;
+        state["jitter/last"] = last_jitter_;
+        state["jitter/max"]  = max_jitter_;
+        for (std::size_t n = 0; n < buckets.size(); ++n) {
+            state["jitter/histogram"][buckets[n]] = histogram_[n];
+        }
+        state["jitter/histogram/inf"] = histogram_[buckets.size()];
+
+        state["offline"] = rendering_;
+        if (rendering_ || render_frames_ > 0) {
+            auto elapsed = seconds((rendering_ ? clock_t::now() : render_end_) - render_start_);
+
+            state["offline/frames"]  = render_frames_;
+            state["offline/time"]    = render_time_;
+            state["offline/elapsed"] = elapsed;
+            state["offline/fps"]     = rendering_ ? render_fps_ : (elapsed > 0.0 ? render_frames_ / elapsed : 0.0);
+            state["offline/speed"]   = elapsed > 0.0 ? render_time_ / elapsed : 0.0;
+        }
+        return state;
+    }
+
+    std::wstring print() const { return L"channel_clock[" + std::to_wstring(channel_index_) + L"]"; }
+
+    static double seconds(clock_t::duration duration)
+    {
+        return std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+    }
+};
+
+constexpr std::array<std::int64_t, 7> channel_clock::impl::buckets;
+
+channel_clock::channel_clock(spl::shared_ptr<diagnostics::graph> graph, int channel_index)
+    : impl_(new impl(std::move(graph), channel_index))
+{
+}
+channel_clock::~channel_clock() {}
+void channel_clock::tick(const boost::rational<int>& framerate, bool external) { impl_->tick(framerate, external); }
+void channel_clock::genlock(bool enabled, std::chrono::nanoseconds phase) { impl_->genlock(enabled, phase); }
+void channel_clock::offline(bool enabled) { impl_->offline(enabled); }
+void channel_clock::reset() { impl_->reset(); }
+core::monitor::state channel_clock::state() const { return impl_->state(); }
+
+}} // namespace caspar::core
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+
+
+#pragma once
+
+#include "monitor/monitor.h"
+
+#include <common/forward.h>
+#include <common/memory.h>
+
+#include <boost/rational.hpp>
+
+#include <chrono>
+
+FORWARD2(caspar, diagnostics, class graph);
+
+namespace caspar { namespace core {
+
+/**
+ * Paces a channel.
+ *
+ * Ticks are scheduled in exact rational time from the channel framerate, so
+ * 59.94 and 29.97 channels do not drift. Each tick sleeps until shortly before
+ * its deadline and spins the rest of the way to avoid OS sleep jitter. A tick
+ * which is late by less than configuration.clock.catch-up frames is returned
+ * immediately so the channel catches up, anything later skips the missed ticks
+ * and continues on the schedule.
+ *
+ * Every channel follows its own timeline unless it is genlocked, in which case
+ * it ticks on the timeline shared by all genlocked channels, delayed by its
+ * phase offset. A channel whose consumer has a synchronization clock is not
+ * paced at all, but the first such channel on the genlock timeline becomes its
+ * source, so the other channels follow the external clock. The phase error of
+ * every genlocked channel is published as "genlock" in the system state.
+ *
+ * An offline channel is not paced either, it renders as fast as its consumers
+ * take the frames. The clock then reports how many frames were rendered and
+ * at which rate, both live in its state and once the channel leaves offline.
+ */
+class channel_clock final
+{
+  public:
+    channel_clock(spl::shared_ptr<diagnostics::graph> graph, int channel_index);
+    ~channel_clock();
+
+    channel_clock(const channel_clock&) = delete;
+    channel_clock& operator=(const channel_clock&) = delete;
+
+    /**
+     * Blocks until the next tick.
+     *
+     * @param framerate Ticks per second.
+     * @param external  The channel was already paced by a consumer, so the
+     *                  tick is only measured.
+     */
+    void tick(const boost::rational<int>& framerate, bool external);
+
+    /**
+     * Moves the channel to or from the genlock timeline from the next tick on.
+     */
+    void genlock(bool enabled, std::chrono::nanoseconds phase);
+
+    /**
+     * Stops or resumes pacing from the next tick on.
+     */
+    void offline(bool enabled);
+
+    void reset();
+
+    core::monitor::state state() const;
+
+  private:
+    struct impl;
+    spl::unique_ptr<impl> impl_;
+};
+
+}} // namespace caspar::core
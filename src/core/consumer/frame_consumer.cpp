@@ -23,6 +23,8 @@
 
 #include "frame_consumer.h"
 
+#include "../destroyer.h"
+
 #include <common/except.h>
 #include <common/future.h>
 
@@ -70,7 +72,11 @@ std::atomic<bool>& destroy_consumers_in_separate_thread()
     return state;
 }
 
-void destroy_consumers_synchronously() { destroy_consumers_in_separate_thread() = false; }
+void destroy_consumers_synchronously()
+{
+    destroy_consumers_in_separate_thread() = false;
+    destroyer::instance().stop();
+}
 
 class destroy_consumer_proxy : public frame_consumer
 {
@@ -85,33 +91,11 @@ class destroy_consumer_proxy : public frame_consumer
 
     ~destroy_consumer_proxy()
     {
-        static std::atomic<int> counter;
-        static std::once_flag   counter_init_once;
-        std::call_once(counter_init_once, [] { counter = 0; });
-
         if (!destroy_consumers_in_separate_thread())
             return;
 
-        ++counter;
-        CASPAR_VERIFY(counter < 8);
-
-        auto consumer = new std::shared_ptr<frame_consumer>(std::move(consumer_));
-        std::thread([=] {
-            std::unique_ptr<std::shared_ptr<frame_consumer>> pointer_guard(consumer);
-            auto                                             str = (*consumer)->print();
-
-            try {
-                if (!consumer->unique())
-                    CASPAR_LOG(debug) << str << L" Not destroyed on asynchronous destruction thread: "
-                                      << consumer->use_count();
-                else
-                    CASPAR_LOG(debug) << str << L" Destroying on asynchronous destruction thread.";
-            } catch (...) {
-            }
-
-            pointer_guard.reset();
-        })
-            .detach();
+        auto name = consumer_->print();
+        destroyer::instance().destroy(name, std::move(consumer_));
     }
 
     std::future<bool> send(const_frame frame) override { return consumer_->send(std::move(frame)); }
@@ -122,6 +106,7 @@ class destroy_consumer_proxy : public frame_consumer
     std::wstring         print() const override { return consumer_->print(); }
     std::wstring         name() const override { return consumer_->name(); }
     bool                 has_synchronization_clock() const override { return consumer_->has_synchronization_clock(); }
+    void                 offline(bool enabled) override { consumer_->offline(enabled); }
     int                  index() const override { return consumer_->index(); }
     core::monitor::state state() const override { return consumer_->state(); }
 };
@@ -153,6 +138,7 @@ class print_consumer_proxy : public frame_consumer
     std::wstring         print() const override { return consumer_->print(); }
     std::wstring         name() const override { return consumer_->name(); }
     bool                 has_synchronization_clock() const override { return consumer_->has_synchronization_clock(); }
+    void                 offline(bool enabled) override { consumer_->offline(enabled); }
     int                  index() const override { return consumer_->index(); }
     core::monitor::state state() const override { return consumer_->state(); }
 };
@@ -59,6 +59,9 @@ class frame_consumer
     virtual std::wstring print() const = 0;
     virtual std::wstring name() const  = 0;
     virtual bool         has_synchronization_clock() const { return false; }
+
+    // An offline channel is paced by its consumers, send() should then wait for room rather than drop the frame.
+    virtual void offline(bool enabled) {}
     virtual int          index() const = 0;
 };
 
@@ -22,6 +22,7 @@
 
 #include "frame_consumer.h"
 
+#include "../channel_clock.h"
 #include "../frame/frame.h"
 #include "../monitor/monitor.h"
 #include "../video_format.h"
@@ -30,16 +31,11 @@
 #include <common/except.h>
 #include <common/memory.h>
 
-#include <boost/optional.hpp>
-
-#include <chrono>
+#include <future>
 #include <map>
-#include <thread>
 
 namespace caspar { namespace core {
 
-typedef decltype(std::chrono::high_resolution_clock::now()) time_point_t;
-
 struct output::impl
 {
     monitor::state                      state_;
@@ -49,14 +45,17 @@ struct output::impl
 
     std::mutex                                     consumers_mutex_;
     std::map<int, spl::shared_ptr<frame_consumer>> consumers_;
+    std::map<int, latency_histogram>               latencies_;
+    bool                                           offline_ = false;
 
-    boost::optional<time_point_t> time_;
+    channel_clock clock_;
 
   public:
     impl(spl::shared_ptr<diagnostics::graph> graph, const video_format_desc& format_desc, int channel_index)
         : graph_(std::move(graph))
         , channel_index_(channel_index)
         , format_desc_(format_desc)
+        , clock_(graph_, channel_index)
     {
     }
 
@@ -67,6 +66,7 @@ struct output::impl
         consumer->initialize(format_desc_, channel_index_);
 
         std::lock_guard<std::mutex> lock(consumers_mutex_);
+        consumer->offline(offline_);
         consumers_.emplace(index, std::move(consumer));
     }
 
@@ -78,6 +78,7 @@ struct output::impl
         auto                        it = consumers_.find(index);
         if (it != consumers_.end()) {
             consumers_.erase(it);
+            latencies_.erase(index);
             return true;
         }
         return false;
@@ -85,32 +86,52 @@ struct output::impl
 
     bool remove(const spl::shared_ptr<frame_consumer>& consumer) { return remove(consumer->index()); }
 
-    void operator()(const_frame input_frame, const core::video_format_desc& format_desc)
+    void offline(bool enabled)
     {
-        if (!input_frame) {
-            return;
+        {
+            std::lock_guard<std::mutex> lock(consumers_mutex_);
+            offline_ = enabled;
+            for (auto& p : consumers_) {
+                p.second->offline(enabled);
+            }
         }
+        clock_.offline(enabled);
+    }
 
-        if (input_frame.size() != format_desc_.size) {
-            CASPAR_LOG(warning) << print() << L" Invalid input frame size.";
+    void operator()(const_frame input_frame, const core::video_format_desc& format_desc)
+    {
+        if (!input_frame) {
             return;
         }
 
-        auto time = std::move(time_);
-
+        // Checked before the frame size, the first frames after a switch may still be mixed in the old format.
         if (format_desc_ != format_desc) {
             std::lock_guard<std::mutex> lock(consumers_mutex_);
-            for (auto it = consumers_.begin(); it != consumers_.end();) {
+
+            // Devices can take a while to reopen, so all consumers are reinitialized at once.
+            std::map<int, std::future<void>> futures;
+            for (auto& p : consumers_) {
+                auto consumer = p.second;
+                auto index    = p.first;
+                futures.emplace(index,
+                                std::async(std::launch::async, [=] { consumer->initialize(format_desc, index); }));
+            }
+            for (auto& p : futures) {
                 try {
-                    it->second->initialize(format_desc, it->first);
-                    ++it;
+                    p.second.get();
                 } catch (...) {
                     CASPAR_LOG_CURRENT_EXCEPTION();
-                    it = consumers_.erase(it);
+                    consumers_.erase(p.first);
+                    latencies_.erase(p.first);
                 }
             }
             format_desc_ = format_desc;
-            time_        = boost::none;
+            clock_.reset();
+            return;
+        }
+
+        if (input_frame.size() != format_desc_.size) {
+            CASPAR_LOG(warning) << print() << L" Invalid input frame size.";
             return;
         }
 
@@ -128,40 +149,45 @@ struct output::impl
                 ++it;
             } catch (...) {
                 CASPAR_LOG_CURRENT_EXCEPTION();
+                latencies_.erase(it->first);
                 it = consumers_.erase(it);
             }
         }
 
+        auto& timestamps = input_frame.timestamps();
+
         for (auto& p : futures) {
+            auto sent = false;
             try {
-                if (!p.second.get()) {
-                    consumers_.erase(p.first);
-                }
+                sent = p.second.get();
             } catch (...) {
                 CASPAR_LOG_CURRENT_EXCEPTION();
-                consumers_.erase(p.first);
             }
-        }
 
-        monitor::state state;
-        for (auto& p : consumers_) {
-            state["port"][p.first] = p.second->state();
+            // A consumer which is gone must not leave its histogram to the next one on the same port.
+            std::lock_guard<std::mutex> lock(consumers_mutex_);
+            if (!sent) {
+                consumers_.erase(p.first);
+                latencies_.erase(p.first);
+            } else if (consumers_.count(p.first)) {
+                latencies_[p.first].sample(timestamps.created, frame_timestamps::clock_t::now() - timestamps.created);
+            }
         }
-        state_ = std::move(state);
 
         const auto needs_sync = std::all_of(
             consumers_.begin(), consumers_.end(), [](auto& p) { return !p.second->has_synchronization_clock(); });
 
-        if (needs_sync) {
-            if (!time) {
-                time = std::chrono::high_resolution_clock::now();
-            } else {
-                std::this_thread::sleep_until(*time);
-            }
-            time_ = *time + std::chrono::microseconds(static_cast<int>(1e6 / format_desc_.fps));
-        } else {
-            time_.reset();
+        clock_.tick(format_desc_.framerate, !needs_sync);
+
+        std::lock_guard<std::mutex> lock(consumers_mutex_);
+
+        monitor::state state;
+        for (auto& p : consumers_) {
+            state["port"][p.first]            = p.second->state();
+            state["port"][p.first]["latency"] = latencies_[p.first].state(format_desc_.fps);
         }
+        state["clock"] = clock_.state();
+        state_         = std::move(state);
     }
 
     std::wstring print() const { return L"output[" + boost::lexical_cast<std::wstring>(channel_index_) + L"]"; }
@@ -176,6 +202,8 @@ void output::add(int index, const spl::shared_ptr<frame_consumer>& consumer) { i
 void output::add(const spl::shared_ptr<frame_consumer>& consumer) { impl_->add(consumer); }
 bool output::remove(int index) { return impl_->remove(index); }
 bool output::remove(const spl::shared_ptr<frame_consumer>& consumer) { return impl_->remove(consumer); }
+void output::genlock(bool enabled, std::chrono::nanoseconds phase) { impl_->clock_.genlock(enabled, phase); }
+void output::offline(bool enabled) { impl_->offline(enabled); }
 void output::operator()(const_frame frame, const video_format_desc& format_desc)
 {
     return (*impl_)(std::move(frame), format_desc);
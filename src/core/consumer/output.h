@@ -27,6 +27,7 @@
 #include <common/forward.h>
 #include <common/memory.h>
 
+#include <chrono>
 #include <future>
 #include <memory>
 
@@ -50,6 +51,19 @@ class output final
     bool remove(const spl::shared_ptr<frame_consumer>& consumer);
     bool remove(int index);
 
+    /**
+     * Ticks the channel on the timeline shared by all genlocked channels,
+     * phase after each of its ticks.
+     */
+    void genlock(bool enabled, std::chrono::nanoseconds phase);
+
+    /**
+     * Stops pacing the channel by time, so that it runs as fast as the
+     * consumers take the frames. Consumers are told so they wait for their
+     * outputs instead of dropping frames.
+     */
+    void offline(bool enabled);
+
     core::monitor::state state() const;
 
   private:
@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+
+#include "StdAfx.h"
+
+#include "destroyer.h"
+
+#include "monitor/system_state.h"
+
+#include <common/env.h>
+#include <common/log.h>
+#include <common/os/thread.h>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace caspar { namespace core {
+
+namespace {
+
+thread_local int wait_scopes = 0;
+
+} // namespace
+
+struct destroyer::impl
+{
+    typedef std::chrono::steady_clock clock_t;
+
+    struct task
+    {
+        std::wstring          name;
+        std::shared_ptr<void> object;
+        clock_t::time_point   queued;
+    };
+
+    struct running_task
+    {
+        std::wstring        name;
+        clock_t::time_point started;
+        bool                reported = false;
+    };
+
+    const std::size_t               capacity_;
+    const std::chrono::milliseconds max_wait_;
+
+    std::mutex              mutex_;
+    std::condition_variable task_cond_;
+    std::condition_variable space_cond_;
+    std::condition_variable watchdog_cond_;
+    std::deque<task>        tasks_;
+    std::list<running_task> running_;
+    bool                    stopped_ = false;
+
+    std::int64_t destroyed_          = 0;
+    std::int64_t synchronous_        = 0;
+    std::int64_t overflowed_         = 0;
+    std::int64_t stalled_            = 0;
+    double       last_duration_      = 0.0;
+    double       max_duration_       = 0.0;
+    double       total_duration_     = 0.0;
+    double       max_queue_duration_ = 0.0;
+
+    std::vector<std::thread> workers_;
+    std::thread              watchdog_;
+
+    impl()
+        : capacity_(env::properties().get(L"configuration.destroyer.queue-size", 32))
+        , max_wait_(env::properties().get(L"configuration.destroyer.max-wait", 10000))
+    {
+        auto count = std::max(2, std::min(env::properties().get(L"configuration.destroyer.threads", 4), 16));
+
+        for (int n = 0; n < count; ++n) {
+            workers_.emplace_back([this, n] {
+                set_thread_name(L"Destroyer " + std::to_wstring(n));
+                run();
+            });
+        }
+        watchdog_ = std::thread([this] {
+            set_thread_name(L"Destroyer watchdog");
+            watch();
+        });
+    }
+
+    ~impl() { stop(); }
+
+    void destroy(const std::wstring& name, std::shared_ptr<void> object)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            if (!stopped_ && tasks_.size() >= capacity_ && wait_scopes == 0) {
+                // Blocking here would stall a channel, or a worker on a queue only the workers drain.
+                overflowed_ += 1;
+            } else if (!stopped_ && tasks_.size() >= capacity_) {
+                space_cond_.wait_for(lock, max_wait_, [&] { return stopped_ || tasks_.size() < capacity_; });
+
+                if (!stopped_ && tasks_.size() >= capacity_) {
+                    synchronous_ += 1;
+                    lock.unlock();
+
+                    CASPAR_LOG(warning) << name << L" Destruction queue is full, destroying synchronously.";
+                    release(name, std::move(object));
+                    return;
+                }
+            }
+
+            if (!stopped_) {
+                tasks_.push_back(task{name, std::move(object), clock_t::now()});
+                task_cond_.notify_one();
+                return;
+            }
+        }
+
+        release(name, std::move(object));
+    }
+
+    void release(const std::wstring& name, std::shared_ptr<void> object)
+    {
+        try {
+            if (object.use_count() != 1)
+                CASPAR_LOG(debug) << name << L" Not destroyed on asynchronous destruction thread: "
+                                  << object.use_count();
+            else
+                CASPAR_LOG(debug) << name << L" Destroying on asynchronous destruction thread.";
+        } catch (...) {
+        }
+
+        try {
+            object.reset();
+            CASPAR_LOG(info) << name << L" Destroyed.";
+        } catch (...) {
+            CASPAR_LOG_CURRENT_EXCEPTION();
+        }
+    }
+
+    void run()
+    {
+        while (true) {
+            task                              current;
+            std::list<running_task>::iterator it;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                task_cond_.wait(lock, [&] { return stopped_ || !tasks_.empty(); });
+
+                if (tasks_.empty()) {
+                    return;
+                }
+
+                current = std::move(tasks_.front());
+                tasks_.pop_front();
+                space_cond_.notify_one();
+
+                auto now            = clock_t::now();
+                max_queue_duration_ = std::max(max_queue_duration_, seconds(now - current.queued));
+                it                  = running_.insert(running_.end(), running_task{current.name, now});
+            }
+
+            release(current.name, std::move(current.object));
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+
+                auto duration = seconds(clock_t::now() - it->started);
+                if (it->reported) {
+                    CASPAR_LOG(warning) << current.name << L" Destruction finished after " << duration << L" s.";
+                }
+                running_.erase(it);
+
+                destroyed_ += 1;
+                last_duration_ = duration;
+                max_duration_  = std::max(max_duration_, duration);
+                total_duration_ += duration;
+            }
+        }
+    }
+
+    void watch()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        while (!stopped_) {
+            watchdog_cond_.wait_for(lock, std::chrono::seconds(1));
+
+            auto now = clock_t::now();
+            for (auto& task : running_) {
+                if (!task.reported && now - task.started > max_wait_) {
+                    CASPAR_LOG(warning) << task.name << L" Destruction has been running for more than "
+                                        << max_wait_.count() << L" ms.";
+                    task.reported = true;
+                    stalled_ += 1;
+                }
+            }
+        }
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopped_) {
+                return;
+            }
+            stopped_ = true;
+        }
+        task_cond_.notify_all();
+        space_cond_.notify_all();
+        watchdog_cond_.notify_all();
+
+        // Workers drain the queue before returning.
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+        watchdog_.join();
+    }
+
+    monitor::state state()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        monitor::state state;
+        state["pending"]            = static_cast<std::int64_t>(tasks_.size());
+        state["running"]            = static_cast<std::int64_t>(running_.size());
+        state["capacity"]           = static_cast<std::int64_t>(capacity_);
+        state["threads"]            = static_cast<std::int64_t>(workers_.size());
+        state["destroyed"]          = destroyed_;
+        state["synchronous"]        = synchronous_;
+        state["overflowed"]         = overflowed_;
+        state["stalled"]            = stalled_;
+        state["duration/last"]      = last_duration_;
+        state["duration/max"]       = max_duration_;
+        state["duration/average"]   = destroyed_ > 0 ? total_duration_ / destroyed_ : 0.0;
+        state["queue-duration/max"] = max_queue_duration_;
+        return state;
+    }
+
+    static double seconds(clock_t::duration duration)
+    {
+        return std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+    }
+};
+
+destroyer::destroyer()
+    : impl_(new impl())
+{
+    std::weak_ptr<impl> weak_impl = impl_;
+    monitor::register_system_state("destroyer", [weak_impl] {
+        auto impl = weak_impl.lock();
+        return impl ? impl->state() : monitor::state();
+    });
+}
+
+destroyer::scoped_wait::scoped_wait() { ++wait_scopes; }
+
+destroyer::scoped_wait::~scoped_wait() { --wait_scopes; }
+
+destroyer& destroyer::instance()
+{
+    static destroyer instance;
+    return instance;
+}
+
+void destroyer::destroy(const std::wstring& name, std::shared_ptr<void> object)
+{
+    impl_->destroy(name, std::move(object));
+}
+
+void destroyer::stop() { impl_->stop(); }
+
+}} // namespace caspar::core
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+namespace caspar { namespace core {
+
+/**
+ * Releases producers and consumers on a small pool of threads, so that heavy
+ * teardown (decoders, browsers, devices) neither runs on channel or AMCP
+ * threads nor serializes behind each other.
+ *
+ * The queue is bounded for threads holding a scoped_wait, e.g. AMCP command
+ * threads. When it is full they wait for a free slot and, if none frees up in
+ * time, release the object themselves. Every other thread, channel and stage
+ * threads as well as the pool itself, never blocks and queues past the limit.
+ * Destructions that take unreasonably long are reported by a watchdog.
+ * Counters are published as "destroyer" in the system state.
+ */
+class destroyer
+{
+  public:
+    static destroyer& instance();
+
+    /**
+     * Lets destroy() calls on the current thread wait for room in a full
+     * queue while in scope.
+     */
+    class scoped_wait
+    {
+      public:
+        scoped_wait();
+        ~scoped_wait();
+
+        scoped_wait(const scoped_wait&) = delete;
+        scoped_wait& operator=(const scoped_wait&) = delete;
+    };
+
+    /**
+     * Releases the reference to object on the pool.
+     *
+     * @param name   Used for logging and metrics.
+     * @param object The object to release.
+     */
+    void destroy(const std::wstring& name, std::shared_ptr<void> object);
+
+    /**
+     * Releases everything still queued and stops the pool. Further objects
+     * are released on the calling thread.
+     */
+    void stop();
+
+  private:
+    destroyer();
+
+    struct impl;
+    std::shared_ptr<impl> impl_;
+};
+
+}} // namespace caspar::core
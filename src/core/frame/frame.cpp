@@ -49,6 +49,7 @@ struct mutable_frame::impl : boost::noncopyable
     const void*                      tag_;
     frame_geometry                   geometry_ = frame_geometry::get_default();
     mutable_frame::commit_t          commit_;
+    frame_timestamps                 timestamps_;
 
     impl(const void*                      tag,
          std::vector<array<std::uint8_t>> image_data,
@@ -61,6 +62,7 @@ struct mutable_frame::impl : boost::noncopyable
         , desc_(desc)
         , commit_(std::move(commit))
     {
+        timestamps_.created = frame_timestamps::clock_t::now();
     }
 };
 
@@ -92,6 +94,8 @@ std::size_t                mutable_frame::width() const { return impl_->desc_.pl
 std::size_t                mutable_frame::height() const { return impl_->desc_.planes.at(0).height; }
 const frame_geometry&      mutable_frame::geometry() const { return impl_->geometry_; }
 frame_geometry&            mutable_frame::geometry() { return impl_->geometry_; }
+frame_timestamps&          mutable_frame::timestamps() { return impl_->timestamps_; }
+const frame_timestamps&    mutable_frame::timestamps() const { return impl_->timestamps_; }
 
 struct const_frame::impl
 {
@@ -100,6 +104,7 @@ struct const_frame::impl
     core::pixel_format_desc                desc_     = pixel_format::invalid;
     frame_geometry                         geometry_ = frame_geometry::get_default();
     boost::any                             opaque_;
+    frame_timestamps                       timestamps_;
 
     impl(std::vector<array<const std::uint8_t>> image_data,
          array<const std::int32_t>              audio_data,
@@ -111,6 +116,7 @@ struct const_frame::impl
         if (desc_.planes.size() != image_data_.size()) {
             CASPAR_THROW_EXCEPTION(invalid_argument());
         }
+        timestamps_.created = frame_timestamps::clock_t::now();
     }
 
     impl(std::vector<array<std::uint8_t>>&& image_data,
@@ -123,6 +129,7 @@ struct const_frame::impl
         if (desc_.planes.size() != image_data_.size()) {
             CASPAR_THROW_EXCEPTION(invalid_argument());
         }
+        timestamps_.created = frame_timestamps::clock_t::now();
     }
 
     impl(mutable_frame&& other)
@@ -131,6 +138,7 @@ struct const_frame::impl
         , audio_data_(std::move(other.impl_->audio_data_))
         , desc_(std::move(other.impl_->desc_))
         , geometry_(std::move(other.impl_->geometry_))
+        , timestamps_(other.impl_->timestamps_)
     {
         if (desc_.planes.size() != image_data_.size()) {
             CASPAR_THROW_EXCEPTION(invalid_argument());
@@ -182,5 +190,16 @@ std::size_t                      const_frame::height() const { return impl_->hei
 std::size_t                      const_frame::size() const { return impl_->size(); }
 const frame_geometry&            const_frame::geometry() const { return impl_->geometry_; }
 const boost::any&                const_frame::opaque() const { return impl_->opaque_; }
+const frame_timestamps&          const_frame::timestamps() const
+{
+    static const frame_timestamps empty;
+    return impl_ ? impl_->timestamps_ : empty;
+}
+void const_frame::timestamps(const frame_timestamps& timestamps)
+{
+    if (impl_) {
+        impl_->timestamps_ = timestamps;
+    }
+}
 const_frame::operator bool() const { return impl_ != nullptr && impl_->desc_.format != core::pixel_format::invalid; }
 }} // namespace caspar::core
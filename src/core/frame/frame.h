@@ -1,5 +1,7 @@
 #pragma once
 
+#include "frame_timestamps.h"
+
 #include <common/array.h>
 
 #include <boost/any.hpp>
@@ -49,6 +51,9 @@ class mutable_frame final
     class frame_geometry&       geometry();
     const class frame_geometry& geometry() const;
 
+    frame_timestamps&       timestamps();
+    const frame_timestamps& timestamps() const;
+
   private:
     struct impl;
     std::unique_ptr<impl> impl_;
@@ -84,6 +89,11 @@ class const_frame final
 
     const class frame_geometry& geometry() const;
 
+    const frame_timestamps& timestamps() const;
+
+    // Only meant for whoever created the frame, before it is handed on.
+    void timestamps(const frame_timestamps& timestamps);
+
     bool operator==(const const_frame& other) const;
     bool operator!=(const const_frame& other) const;
     bool operator<(const const_frame& other) const;
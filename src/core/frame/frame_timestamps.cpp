@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+
+
+#include "../StdAfx.h"
+
+#include "frame_timestamps.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace caspar { namespace core {
+
+constexpr std::array<std::int64_t, 8> latency_histogram::buckets;
+
+void latency_histogram::sample(frame_timestamps::clock_t::time_point created,
+                               frame_timestamps::clock_t::duration   latency)
+{
+    if (created == frame_timestamps::clock_t::time_point() || created == last_created_) {
+        return;
+    }
+    last_created_ = created;
+
+    auto ms = std::chrono::duration<double, std::milli>(latency).count();
+
+    samples_ += 1;
+    last_ = ms;
+    max_  = std::max(max_, ms);
+    total_ += ms;
+
+    auto it = std::lower_bound(buckets.begin(), buckets.end(), static_cast<std::int64_t>(std::ceil(ms)));
+    histogram_[it - buckets.begin()] += 1;
+}
+
+core::monitor::state latency_histogram::state(double fps) const
+{
+    core::monitor::state state;
+    state["samples"] = samples_;
+    state["last"]    = last_;
+    state["max"]     = max_;
+    state["average"] = samples_ > 0 ? total_ / samples_ : 0.0;
+    if (fps > 0.0) {
+        state["frames/last"]    = last_ * fps / 1000.0;
+        state["frames/average"] = samples_ > 0 ? total_ / samples_ * fps / 1000.0 : 0.0;
+    }
+    for (std::size_t n = 0; n < buckets.size(); ++n) {
+        state["histogram"][buckets[n]] = histogram_[n];
+    }
+    state["histogram/inf"] = histogram_[buckets.size()];
+    return state;
+}
+
+}} // namespace caspar::core
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+
+
+#pragma once
+
+#include "../monitor/monitor.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace caspar { namespace core {
+
+/**
+ * Monotonic times at which a frame passed the stages of a channel. Frames
+ * are stamped as created when a producer makes them, a mixed frame carries
+ * the creation time of the newest frame it was mixed from.
+ */
+struct frame_timestamps
+{
+    typedef std::chrono::steady_clock clock_t;
+
+    clock_t::time_point created;  // Made by a producer (decoded, captured, rendered).
+    clock_t::time_point produced; // Handed by the stage to the mixer.
+    clock_t::time_point mixed;    // Read back from the mixer.
+};
+
+/**
+ * Aggregates latencies into a histogram of milliseconds. Samples of the same
+ * content are only counted once, so that a still or a paused frame does not
+ * show up as an ever growing latency.
+ */
+class latency_histogram final
+{
+  public:
+    /**
+     * @param created Creation time of the content, used to skip repeats.
+     * @param latency The latency to record.
+     */
+    void sample(frame_timestamps::clock_t::time_point created, frame_timestamps::clock_t::duration latency);
+
+    /**
+     * @param fps If given, latencies are also reported in frames.
+     */
+    core::monitor::state state(double fps = 0.0) const;
+
+  private:
+    static constexpr std::array<std::int64_t, 8> buckets = {{5, 10, 20, 40, 80, 160, 320, 640}};
+
+    frame_timestamps::clock_t::time_point        last_created_;
+    std::int64_t                                 samples_   = 0;
+    double                                       last_      = 0.0;
+    double                                       max_       = 0.0;
+    double                                       total_     = 0.0;
+    std::array<std::int64_t, buckets.size() + 1> histogram_ = {};
+};
+
+}} // namespace caspar::core
@@ -112,79 +112,77 @@ image_transform image_transform::operator*(const image_transform& other) const
     return image_transform(*this) *= other;
 }
 
-double do_tween(double time, double source, double dest, double duration, const tweener& tween)
+// Interpolates all fields with the same eased progress, evaluated once per tick.
+struct weighted_tween
 {
-    return tween(time, source, dest - source, duration);
+    double weight;
+
+    double operator()(double source, double dest) const { return source + (dest - source) * weight; }
 };
 
-template <typename Rect>
-void do_tween_rectangle(const Rect&    source,
-                        const Rect&    dest,
-                        Rect&          out,
-                        double         time,
-                        double         duration,
-                        const tweener& tweener)
+// Fallback for tweens whose curve depends on the distance travelled.
+struct exact_tween
 {
-    out.ul[0] = do_tween(time, source.ul[0], dest.ul[0], duration, tweener);
-    out.ul[1] = do_tween(time, source.ul[1], dest.ul[1], duration, tweener);
-    out.lr[0] = do_tween(time, source.lr[0], dest.lr[0], duration, tweener);
-    out.lr[1] = do_tween(time, source.lr[1], dest.lr[1], duration, tweener);
+    double         time;
+    double         duration;
+    const tweener& tween;
+
+    double operator()(double source, double dest) const { return tween(time, source, dest - source, duration); }
+};
+
+template <typename Rect, typename Tween>
+void do_tween_rectangle(const Rect& source, const Rect& dest, Rect& out, const Tween& tween)
+{
+    out.ul[0] = tween(source.ul[0], dest.ul[0]);
+    out.ul[1] = tween(source.ul[1], dest.ul[1]);
+    out.lr[0] = tween(source.lr[0], dest.lr[0]);
+    out.lr[1] = tween(source.lr[1], dest.lr[1]);
 }
 
-void do_tween_corners(const corners& source,
-                      const corners& dest,
-                      corners&       out,
-                      double         time,
-                      double         duration,
-                      const tweener& tweener)
+template <typename Tween>
+void do_tween_corners(const corners& source, const corners& dest, corners& out, const Tween& tween)
 {
-    do_tween_rectangle(source, dest, out, time, duration, tweener);
+    do_tween_rectangle(source, dest, out, tween);
 
-    out.ur[0] = do_tween(time, source.ur[0], dest.ur[0], duration, tweener);
-    out.ur[1] = do_tween(time, source.ur[1], dest.ur[1], duration, tweener);
-    out.ll[0] = do_tween(time, source.ll[0], dest.ll[0], duration, tweener);
-    out.ll[1] = do_tween(time, source.ll[1], dest.ll[1], duration, tweener);
+    out.ur[0] = tween(source.ur[0], dest.ur[0]);
+    out.ur[1] = tween(source.ur[1], dest.ur[1]);
+    out.ll[0] = tween(source.ll[0], dest.ll[0]);
+    out.ll[1] = tween(source.ll[1], dest.ll[1]);
 };
 
-image_transform image_transform::tween(double                 time,
-                                       const image_transform& source,
-                                       const image_transform& dest,
-                                       double                 duration,
-                                       const tweener&         tween)
+template <typename Tween>
+image_transform do_tween(const image_transform& source, const image_transform& dest, const Tween& tween)
 {
     image_transform result;
 
-    result.brightness          = do_tween(time, source.brightness, dest.brightness, duration, tween);
-    result.contrast            = do_tween(time, source.contrast, dest.contrast, duration, tween);
-    result.saturation          = do_tween(time, source.saturation, dest.saturation, duration, tween);
-    result.opacity             = do_tween(time, source.opacity, dest.opacity, duration, tween);
-    result.anchor[0]           = do_tween(time, source.anchor[0], dest.anchor[0], duration, tween);
-    result.anchor[1]           = do_tween(time, source.anchor[1], dest.anchor[1], duration, tween);
-    result.fill_translation[0] = do_tween(time, source.fill_translation[0], dest.fill_translation[0], duration, tween);
-    result.fill_translation[1] = do_tween(time, source.fill_translation[1], dest.fill_translation[1], duration, tween);
-    result.fill_scale[0]       = do_tween(time, source.fill_scale[0], dest.fill_scale[0], duration, tween);
-    result.fill_scale[1]       = do_tween(time, source.fill_scale[1], dest.fill_scale[1], duration, tween);
-    result.clip_translation[0] = do_tween(time, source.clip_translation[0], dest.clip_translation[0], duration, tween);
-    result.clip_translation[1] = do_tween(time, source.clip_translation[1], dest.clip_translation[1], duration, tween);
-    result.clip_scale[0]       = do_tween(time, source.clip_scale[0], dest.clip_scale[0], duration, tween);
-    result.clip_scale[1]       = do_tween(time, source.clip_scale[1], dest.clip_scale[1], duration, tween);
-    result.angle               = do_tween(time, source.angle, dest.angle, duration, tween);
-    result.levels.max_input    = do_tween(time, source.levels.max_input, dest.levels.max_input, duration, tween);
-    result.levels.min_input    = do_tween(time, source.levels.min_input, dest.levels.min_input, duration, tween);
-    result.levels.max_output   = do_tween(time, source.levels.max_output, dest.levels.max_output, duration, tween);
-    result.levels.min_output   = do_tween(time, source.levels.min_output, dest.levels.min_output, duration, tween);
-    result.levels.gamma        = do_tween(time, source.levels.gamma, dest.levels.gamma, duration, tween);
-    result.chroma.target_hue   = do_tween(time, source.chroma.target_hue, dest.chroma.target_hue, duration, tween);
-    result.chroma.hue_width    = do_tween(time, source.chroma.hue_width, dest.chroma.hue_width, duration, tween);
-    result.chroma.min_saturation =
-        do_tween(time, source.chroma.min_saturation, dest.chroma.min_saturation, duration, tween);
-    result.chroma.min_brightness =
-        do_tween(time, source.chroma.min_brightness, dest.chroma.min_brightness, duration, tween);
-    result.chroma.softness = do_tween(time, source.chroma.softness, dest.chroma.softness, duration, tween);
-    result.chroma.spill_suppress =
-        do_tween(time, source.chroma.spill_suppress, dest.chroma.spill_suppress, duration, tween);
+    result.brightness                       = tween(source.brightness, dest.brightness);
+    result.contrast                         = tween(source.contrast, dest.contrast);
+    result.saturation                       = tween(source.saturation, dest.saturation);
+    result.opacity                          = tween(source.opacity, dest.opacity);
+    result.anchor[0]                        = tween(source.anchor[0], dest.anchor[0]);
+    result.anchor[1]                        = tween(source.anchor[1], dest.anchor[1]);
+    result.fill_translation[0]              = tween(source.fill_translation[0], dest.fill_translation[0]);
+    result.fill_translation[1]              = tween(source.fill_translation[1], dest.fill_translation[1]);
+    result.fill_scale[0]                    = tween(source.fill_scale[0], dest.fill_scale[0]);
+    result.fill_scale[1]                    = tween(source.fill_scale[1], dest.fill_scale[1]);
+    result.clip_translation[0]              = tween(source.clip_translation[0], dest.clip_translation[0]);
+    result.clip_translation[1]              = tween(source.clip_translation[1], dest.clip_translation[1]);
+    result.clip_scale[0]                    = tween(source.clip_scale[0], dest.clip_scale[0]);
+    result.clip_scale[1]                    = tween(source.clip_scale[1], dest.clip_scale[1]);
+    result.angle                            = tween(source.angle, dest.angle);
+    result.levels.max_input                 = tween(source.levels.max_input, dest.levels.max_input);
+    result.levels.min_input                 = tween(source.levels.min_input, dest.levels.min_input);
+    result.levels.max_output                = tween(source.levels.max_output, dest.levels.max_output);
+    result.levels.min_output                = tween(source.levels.min_output, dest.levels.min_output);
+    result.levels.gamma                     = tween(source.levels.gamma, dest.levels.gamma);
+    result.chroma.target_hue                = tween(source.chroma.target_hue, dest.chroma.target_hue);
+    result.chroma.hue_width                 = tween(source.chroma.hue_width, dest.chroma.hue_width);
+    result.chroma.min_saturation            = tween(source.chroma.min_saturation, dest.chroma.min_saturation);
+    result.chroma.min_brightness            = tween(source.chroma.min_brightness, dest.chroma.min_brightness);
+    result.chroma.softness                  = tween(source.chroma.softness, dest.chroma.softness);
+    result.chroma.spill_suppress            = tween(source.chroma.spill_suppress, dest.chroma.spill_suppress);
     result.chroma.spill_suppress_saturation =
-        do_tween(time, source.chroma.spill_suppress_saturation, dest.chroma.spill_suppress_saturation, duration, tween);
+        tween(source.chroma.spill_suppress_saturation, dest.chroma.spill_suppress_saturation);
     result.chroma.enable    = dest.chroma.enable;
     result.chroma.show_mask = dest.chroma.show_mask;
     result.is_key           = source.is_key | dest.is_key;
@@ -193,12 +191,39 @@ image_transform image_transform::tween(double                 time,
     result.blend_mode       = std::max(source.blend_mode, dest.blend_mode);
     result.layer_depth      = dest.layer_depth;
 
-    do_tween_rectangle(source.crop, dest.crop, result.crop, time, duration, tween);
-    do_tween_corners(source.perspective, dest.perspective, result.perspective, time, duration, tween);
+    do_tween_rectangle(source.crop, dest.crop, result.crop, tween);
+    do_tween_corners(source.perspective, dest.perspective, result.perspective, tween);
+
+    return result;
+}
+
+template <typename Tween>
+audio_transform do_tween(const audio_transform& source, const audio_transform& dest, const Tween& tween)
+{
+    audio_transform result;
+    result.volume = tween(source.volume, dest.volume);
 
     return result;
 }
 
+template <typename Transform>
+Transform do_tween(double time, const Transform& source, const Transform& dest, double duration, const tweener& tween)
+{
+    if (tween.has_weight()) {
+        return do_tween(source, dest, weighted_tween{tween.weight(time, duration)});
+    }
+    return do_tween(source, dest, exact_tween{time, duration, tween});
+}
+
+image_transform image_transform::tween(double                 time,
+                                       const image_transform& source,
+                                       const image_transform& dest,
+                                       double                 duration,
+                                       const tweener&         tween)
+{
+    return do_tween(time, source, dest, duration, tween);
+}
+
 bool eq(double lhs, double rhs) { return std::abs(lhs - rhs) < 5e-8; };
 
 bool operator==(const corners& lhs, const corners& rhs)
@@ -252,10 +277,7 @@ audio_transform audio_transform::tween(double                 time,
                                        double                 duration,
                                        const tweener&         tween)
 {
-    audio_transform result;
-    result.volume = do_tween(time, source.volume, dest.volume, duration, tween);
-
-    return result;
+    return do_tween(time, source, dest, duration, tween);
 }
 
 bool operator==(const audio_transform& lhs, const audio_transform& rhs) { return eq(lhs.volume, rhs.volume); }
@@ -284,10 +306,15 @@ frame_transform frame_transform::tween(double                 time,
                                        const tweener&         tween)
 {
     frame_transform result;
-    result.image_transform =
-        image_transform::tween(time, source.image_transform, dest.image_transform, duration, tween);
-    result.audio_transform =
-        audio_transform::tween(time, source.audio_transform, dest.audio_transform, duration, tween);
+    if (tween.has_weight()) {
+        weighted_tween weighted{tween.weight(time, duration)};
+        result.image_transform = do_tween(source.image_transform, dest.image_transform, weighted);
+        result.audio_transform = do_tween(source.audio_transform, dest.audio_transform, weighted);
+    } else {
+        exact_tween exact{time, duration, tween};
+        result.image_transform = do_tween(source.image_transform, dest.image_transform, exact);
+        result.audio_transform = do_tween(source.audio_transform, dest.audio_transform, exact);
+    }
     return result;
 }
 
@@ -309,7 +336,11 @@ tweened_transform::tweened_transform(const frame_transform& source,
 {
 }
 
+const frame_transform& tweened_transform::source() const { return source_; }
 const frame_transform& tweened_transform::dest() const { return dest_; }
+int                    tweened_transform::duration() const { return duration_; }
+int                    tweened_transform::time() const { return time_; }
+const tweener&         tweened_transform::tween() const { return tweener_; }
 
 frame_transform tweened_transform::fetch()
 {
@@ -164,7 +164,11 @@ class tweened_transform
 
     tweened_transform(const frame_transform& source, const frame_transform& dest, int duration, const tweener& tween);
 
+    const frame_transform& source() const;
     const frame_transform& dest() const;
+    int                    duration() const;
+    int                    time() const;
+    const tweener&         tween() const;
 
     frame_transform fetch();
     void            tick(int num);
@@ -38,6 +38,7 @@
 #include <core/frame/draw_frame.h>
 #include <core/frame/frame_factory.h>
 #include <core/frame/frame_transform.h>
+#include <core/frame/frame_visitor.h>
 #include <core/frame/pixel_format.h>
 #include <core/video_format.h>
 
@@ -52,58 +53,112 @@
 
 namespace caspar { namespace core {
 
+// Finds the creation time of the newest frame a layer tree was built from.
+struct newest_frame_visitor : public frame_visitor
+{
+    frame_timestamps::clock_t::time_point created;
+
+    void push(const frame_transform& transform) override {}
+    void visit(const const_frame& frame) override { created = std::max(created, frame.timestamps().created); }
+    void pop() override {}
+};
+
 struct mixer::impl : boost::noncopyable
 {
-    monitor::state                       state_;
-    int                                  channel_index_;
-    spl::shared_ptr<diagnostics::graph>  graph_;
-    audio_mixer                          audio_mixer_{graph_};
-    spl::shared_ptr<image_mixer>         image_mixer_;
-    std::queue<std::future<const_frame>> buffer_;
+    // A mixed frame, assembled on the readback executor as soon as its image has been read back from the GPU.
+    struct pending_frame
+    {
+        const_frame frame;
+        double      wait = 0.0;
+    };
+
+    monitor::state                         state_;
+    int                                    channel_index_;
+    spl::shared_ptr<diagnostics::graph>    graph_;
+    audio_mixer                            audio_mixer_{graph_};
+    spl::shared_ptr<image_mixer>           image_mixer_;
+    std::queue<std::future<pending_frame>> buffer_;
+    std::atomic<int>                       readback_depth_{1};
+    executor                               readback_executor_;
 
   public:
     impl(int channel_index, spl::shared_ptr<diagnostics::graph> graph, spl::shared_ptr<image_mixer> image_mixer)
         : channel_index_(channel_index)
         , graph_(std::move(graph))
         , image_mixer_(std::move(image_mixer))
+        , readback_executor_(L"mixer-readback " + boost::lexical_cast<std::wstring>(channel_index))
     {
+        graph_->set_color("readback-time", diagnostics::color(0.2f, 0.6f, 0.9f, 0.8f));
     }
 
     const_frame operator()(std::vector<draw_frame> frames, const video_format_desc& format_desc, int nb_samples)
     {
+        frame_timestamps     timestamps;
+        newest_frame_visitor newest;
+
+        timestamps.produced = frame_timestamps::clock_t::now();
+
         for (auto& frame : frames) {
+            frame.accept(newest);
             frame.accept(audio_mixer_);
             frame.transform().image_transform.layer_depth = 1;
             frame.accept(*image_mixer_);
         }
 
-        auto image = (*image_mixer_)(format_desc);
-        auto audio = audio_mixer_(format_desc, nb_samples);
+        auto image = std::make_shared<std::future<array<const std::uint8_t>>>((*image_mixer_)(format_desc));
+        auto audio = std::make_shared<array<const std::int32_t>>(audio_mixer_(format_desc, nb_samples));
 
         state_["audio"] = audio_mixer_.state();
 
-        buffer_.push(std::async(
-            std::launch::deferred,
-            [image = std::move(image), audio = std::move(audio), graph = graph_, format_desc, tag = this]() mutable {
-                auto desc = pixel_format_desc(pixel_format::bgra);
-                desc.planes.push_back(pixel_format_desc::plane(format_desc.width, format_desc.height, 4));
-                std::vector<array<const uint8_t>> image_data;
-                image_data.emplace_back(std::move(image.get()));
-                return const_frame(std::move(image_data), std::move(audio), desc);
-            }));
-
-        if (buffer_.size() < 2) {
+        timestamps.created = newest.created;
+
+        buffer_.push(readback_executor_.begin_invoke([=]() mutable {
+            caspar::timer readback_timer;
+            auto          readback = image->get();
+
+            pending_frame result;
+            result.wait = readback_timer.elapsed();
+
+            auto desc = pixel_format_desc(pixel_format::bgra);
+            desc.planes.push_back(pixel_format_desc::plane(format_desc.width, format_desc.height, 4));
+            std::vector<array<const uint8_t>> image_data;
+            image_data.emplace_back(std::move(readback));
+
+            result.frame     = const_frame(std::move(image_data), std::move(*audio), desc);
+            timestamps.mixed = frame_timestamps::clock_t::now();
+            result.frame.timestamps(timestamps);
+
+            graph_->set_value("readback-time", result.wait * format_desc.fps * 0.5);
+
+            return result;
+        }));
+
+        // The readback of the frames behind the one returned overlaps with the next ticks. If the depth was lowered
+        // the oldest frames are dropped so that the latency goes down right away.
+        auto depth = static_cast<std::size_t>(readback_depth_);
+        if (buffer_.size() <= depth) {
             return const_frame{};
         }
+        while (buffer_.size() > depth + 1) {
+            buffer_.pop();
+        }
 
-        auto frame = std::move(buffer_.front().get());
+        auto pending = buffer_.front().get();
         buffer_.pop();
-        return frame;
+
+        state_["readback/depth"] = static_cast<std::int32_t>(depth);
+        state_["readback/wait"]  = pending.wait;
+
+        return pending.frame;
     }
 
     void set_master_volume(float volume) { audio_mixer_.set_master_volume(volume); }
 
     float get_master_volume() { return audio_mixer_.get_master_volume(); }
+
+    void set_readback_depth(int depth) { readback_depth_ = std::max(0, std::min(depth, 8)); }
+
+    int get_readback_depth() const { return readback_depth_; }
 };
 
 mixer::mixer(int channel_index, spl::shared_ptr<diagnostics::graph> graph, spl::shared_ptr<image_mixer> image_mixer)
@@ -112,6 +167,8 @@ mixer::mixer(int channel_index, spl::shared_ptr<diagnostics::graph> graph, spl::
 }
 void        mixer::set_master_volume(float volume) { impl_->set_master_volume(volume); }
 float       mixer::get_master_volume() { return impl_->get_master_volume(); }
+void        mixer::set_readback_depth(int depth) { impl_->set_readback_depth(depth); }
+int         mixer::get_readback_depth() const { return impl_->get_readback_depth(); }
 const_frame mixer::operator()(std::vector<draw_frame> frames, const video_format_desc& format_desc, int nb_samples)
 {
     return (*impl_)(std::move(frames), format_desc, nb_samples);
@@ -53,6 +53,14 @@ class mixer final
     void  set_master_volume(float volume);
     float get_master_volume();
 
+    /**
+     * Sets how many frames are mixed ahead while earlier ones are read back
+     * from the GPU. Every frame of depth adds a frame of latency, 0 waits for
+     * the readback of the frame just mixed.
+     */
+    void set_readback_depth(int depth);
+    int  get_readback_depth() const;
+
     mutable_frame create_frame(const void* tag, const pixel_format_desc& desc);
 
     core::monitor::state state() const;
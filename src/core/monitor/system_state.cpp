@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+
+#include "../StdAfx.h"
+
+#include "system_state.h"
+
+#include <common/log.h>
+
+#include <map>
+#include <mutex>
+
+namespace caspar { namespace core { namespace monitor {
+
+static std::mutex                              g_providers_mutex;
+static std::map<std::string, state_provider_t> g_providers;
+
+void register_system_state(const std::string& name, state_provider_t provider)
+{
+    std::lock_guard<std::mutex> lock(g_providers_mutex);
+
+    g_providers[name] = std::move(provider);
+}
+
+state system_state()
+{
+    std::map<std::string, state_provider_t> providers;
+    {
+        std::lock_guard<std::mutex> lock(g_providers_mutex);
+        providers = g_providers;
+    }
+
+    state result;
+    for (auto& p : providers) {
+        try {
+            result[p.first] = p.second();
+        } catch (...) {
+            CASPAR_LOG_CURRENT_EXCEPTION();
+        }
+    }
+    return result;
+}
+
+}}} // namespace caspar::core::monitor
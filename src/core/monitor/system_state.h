@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+
+#pragma once
+
+#include "monitor.h"
+
+#include <functional>
+#include <string>
+
+namespace caspar { namespace core { namespace monitor {
+
+typedef std::function<state()> state_provider_t;
+
+// Registers process wide state (caches, pools, etc.) which is not owned by any channel. The provider is polled on
+// demand, e.g. by AMCP INFO SYSTEM, and must be thread-safe.
+void  register_system_state(const std::string& name, state_provider_t provider);
+state system_state();
+
+}}} // namespace caspar::core::monitor
@@ -24,6 +24,7 @@
 #include "cg_proxy.h"
 #include "frame_producer.h"
 
+#include "../destroyer.h"
 #include "../frame/draw_frame.h"
 #include "../frame/frame_transform.h"
 
@@ -33,7 +34,6 @@
 
 #include <common/assert.h>
 #include <common/except.h>
-#include <common/executor.h>
 #include <common/future.h>
 #include <common/memory.h>
 
@@ -66,6 +66,7 @@ frame_producer_dependencies::frame_producer_dependencies(
     , format_desc(format_desc)
     , producer_registry(producer_registry)
     , cg_registry(cg_registry)
+    , offline(std::make_shared<std::atomic<bool>>(false))
 {
 }
 
@@ -94,18 +95,6 @@ const spl::shared_ptr<frame_producer>& frame_producer::empty()
     return producer;
 }
 
-std::shared_ptr<executor>& producer_destroyer()
-{
-    static auto destroyer = [] {
-        auto result = std::make_shared<executor>(L"Producer destroyer");
-        result->set_capacity(std::numeric_limits<unsigned int>::max());
-        return result;
-    }();
-    ;
-
-    return destroyer;
-}
-
 std::atomic<bool>& destroy_producers_in_separate_thread()
 {
     static std::atomic<bool> state;
@@ -117,7 +106,7 @@ void destroy_producers_synchronously()
 {
     destroy_producers_in_separate_thread() = false;
     // Join destroyer, executing rest of producers in queue synchronously.
-    producer_destroyer().reset();
+    destroyer::instance().stop();
 }
 
 class destroy_producer_proxy : public frame_producer
@@ -136,34 +125,8 @@ class destroy_producer_proxy : public frame_producer
         if (producer_ == core::frame_producer::empty() || !destroy_producers_in_separate_thread())
             return;
 
-        auto destroyer = producer_destroyer();
-
-        if (!destroyer)
-            return;
-
-        CASPAR_VERIFY(destroyer->size() < 8);
-
-        auto producer = new spl::shared_ptr<frame_producer>(std::move(producer_));
-
-        destroyer->begin_invoke([=] {
-            std::unique_ptr<spl::shared_ptr<frame_producer>> pointer_guard(producer);
-            auto                                             str = (*producer)->print();
-            try {
-                if (!producer->unique())
-                    CASPAR_LOG(debug) << str << L" Not destroyed on asynchronous destruction thread: "
-                                      << producer->use_count();
-                else
-                    CASPAR_LOG(debug) << str << L" Destroying on asynchronous destruction thread.";
-            } catch (...) {
-            }
-
-            try {
-                pointer_guard.reset();
-                CASPAR_LOG(info) << str << L" Destroyed.";
-            } catch (...) {
-                CASPAR_LOG_CURRENT_EXCEPTION();
-            }
-        });
+        auto name = producer_->print();
+        destroyer::instance().destroy(name, std::move(producer_));
     }
 
     draw_frame                receive_impl(int nb_samples) override { return producer_->receive(nb_samples); }
@@ -179,6 +142,10 @@ class destroy_producer_proxy : public frame_producer
     draw_frame           last_frame() override { return producer_->last_frame(); }
     draw_frame           first_frame() override { return producer_->first_frame(); }
     core::monitor::state state() const override { return producer_->state(); }
+    void                 format_desc(const video_format_desc& format_desc) override
+    {
+        producer_->format_desc(format_desc);
+    }
 };
 
 spl::shared_ptr<core::frame_producer> create_destroy_proxy(spl::shared_ptr<core::frame_producer> producer)
@@ -33,6 +33,7 @@
 #include <boost/noncopyable.hpp>
 #include <boost/optional.hpp>
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <future>
@@ -115,6 +116,11 @@ class frame_producer
     virtual void                            leading_producer(const spl::shared_ptr<frame_producer>&) {}
     virtual spl::shared_ptr<frame_producer> following_producer() const { return core::frame_producer::empty(); }
     virtual boost::optional<int64_t>        auto_play_delta() const { return boost::none; }
+
+    // The channel switched format. The ffmpeg, decklink, html and route producers reconfigure themselves from here
+    // on. Stills, colors and image sequences are only scaled by the mixer. Bluefish and flash producers keep the
+    // frame rate they were loaded with and must be reloaded after a frame-rate change.
+    virtual void format_desc(const video_format_desc& format_desc) {}
 };
 
 class frame_producer_registry;
@@ -126,6 +132,7 @@ struct frame_producer_dependencies
     video_format_desc                              format_desc;
     spl::shared_ptr<const frame_producer_registry> producer_registry;
     spl::shared_ptr<const cg_producer_registry>    cg_registry;
+    std::shared_ptr<const std::atomic<bool>>       offline; // Set while frames must not be dropped, see video_channel.
 
     frame_producer_dependencies(const spl::shared_ptr<core::frame_factory>&           frame_factory,
                                 const std::vector<spl::shared_ptr<video_channel>>&    channels,
@@ -43,25 +43,38 @@ struct layer::impl
     spl::shared_ptr<frame_producer> foreground_ = frame_producer::empty();
     spl::shared_ptr<frame_producer> background_ = frame_producer::empty();
 
+    std::vector<std::wstring> foreground_source_;
+    std::vector<std::wstring> background_source_;
+
     bool auto_play_ = false;
     bool paused_    = false;
 
+    video_format_desc format_desc_; // Of the last receive, invalid before the first one.
+
   public:
     void pause() { paused_ = true; }
 
     void resume() { paused_ = false; }
 
-    void load(spl::shared_ptr<frame_producer> producer, bool preview, bool auto_play)
+    void load(spl::shared_ptr<frame_producer> producer, bool preview, bool auto_play, std::vector<std::wstring> source)
     {
-        background_ = std::move(producer);
-        auto_play_  = auto_play;
+        background_        = std::move(producer);
+        background_source_ = std::move(source);
+        auto_play_         = auto_play;
+
+        // The producer may have been created for the format the channel just switched away from.
+        if (format_desc_.format != video_format::invalid) {
+            background_->format_desc(format_desc_);
+        }
 
         if (auto_play_ && foreground_ == frame_producer::empty()) {
             play();
         } else if (preview) {
-            foreground_ = std::move(background_);
-            background_ = frame_producer::empty();
-            paused_     = true;
+            foreground_        = std::move(background_);
+            foreground_source_ = std::move(background_source_);
+            background_        = frame_producer::empty();
+            background_source_.clear();
+            paused_ = true;
         }
     }
 
@@ -74,8 +87,10 @@ struct layer::impl
                 background_->leading_producer(spl::make_shared<core::frame_producer>(foreground_->last_frame()));
             }
 
-            foreground_ = std::move(background_);
-            background_ = frame_producer::empty();
+            foreground_        = std::move(background_);
+            foreground_source_ = std::move(background_source_);
+            background_        = frame_producer::empty();
+            background_source_.clear();
 
             auto_play_ = false;
         }
@@ -86,12 +101,20 @@ struct layer::impl
     void stop()
     {
         foreground_ = frame_producer::empty();
-        auto_play_  = false;
+        foreground_source_.clear();
+        auto_play_ = false;
     }
 
     draw_frame receive(const video_format_desc& format_desc, int nb_samples)
     {
         try {
+            // Layers produce on their own threads, so the producers of all layers reconfigure in parallel.
+            if (format_desc != format_desc_) {
+                foreground_->format_desc(format_desc);
+                background_->format_desc(format_desc);
+                format_desc_ = format_desc;
+            }
+
             if (foreground_->following_producer() != core::frame_producer::empty()) {
                 foreground_ = foreground_->following_producer();
             }
@@ -142,6 +165,7 @@ struct layer::impl
         } catch (...) {
             CASPAR_LOG_CURRENT_EXCEPTION();
             background_ = frame_producer::empty();
+            background_source_.clear();
             return draw_frame{};
         }
     }
@@ -161,9 +185,12 @@ layer& layer::operator=(layer&& other)
     return *this;
 }
 void layer::swap(layer& other) { impl_.swap(other.impl_); }
-void layer::load(spl::shared_ptr<frame_producer> frame_producer, bool preview, bool auto_play)
+void layer::load(spl::shared_ptr<frame_producer> frame_producer,
+                 bool                            preview,
+                 bool                            auto_play,
+                 std::vector<std::wstring>       source)
 {
-    return impl_->load(std::move(frame_producer), preview, auto_play);
+    return impl_->load(std::move(frame_producer), preview, auto_play, std::move(source));
 }
 void       layer::play() { impl_->play(); }
 void       layer::pause() { impl_->pause(); }
@@ -177,8 +204,12 @@ draw_frame layer::receive_background(const video_format_desc& format_desc, int n
 {
     return impl_->receive_background(format_desc, nb_samples);
 }
-spl::shared_ptr<frame_producer> layer::foreground() const { return impl_->foreground_; }
-spl::shared_ptr<frame_producer> layer::background() const { return impl_->background_; }
-bool                            layer::has_background() const { return impl_->background_ != frame_producer::empty(); }
-core::monitor::state            layer::state() const { return impl_->state_; }
+spl::shared_ptr<frame_producer>  layer::foreground() const { return impl_->foreground_; }
+spl::shared_ptr<frame_producer>  layer::background() const { return impl_->background_; }
+bool                             layer::has_background() const { return impl_->background_ != frame_producer::empty(); }
+bool                             layer::paused() const { return impl_->paused_; }
+bool                             layer::auto_play() const { return impl_->auto_play_; }
+const std::vector<std::wstring>& layer::foreground_source() const { return impl_->foreground_source_; }
+const std::vector<std::wstring>& layer::background_source() const { return impl_->background_source_; }
+core::monitor::state             layer::state() const { return impl_->state_; }
 }} // namespace caspar::core
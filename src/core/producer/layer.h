@@ -30,6 +30,7 @@
 #include <common/memory.h>
 
 #include <string>
+#include <vector>
 
 namespace caspar { namespace core {
 
@@ -46,7 +47,10 @@ class layer final
 
     void swap(layer& other);
 
-    void load(spl::shared_ptr<frame_producer> producer, bool preview, bool auto_play = false);
+    void load(spl::shared_ptr<frame_producer> producer,
+              bool                            preview,
+              bool                            auto_play = false,
+              std::vector<std::wstring>       source    = {});
     void play();
     void pause();
     void resume();
@@ -60,6 +64,12 @@ class layer final
     spl::shared_ptr<frame_producer> foreground() const;
     spl::shared_ptr<frame_producer> background() const;
     bool                            has_background() const;
+    bool                            paused() const;
+    bool                            auto_play() const;
+
+    // The parameters the producers were created from, empty if unknown.
+    const std::vector<std::wstring>& foreground_source() const;
+    const std::vector<std::wstring>& background_source() const;
 
   private:
     struct impl;
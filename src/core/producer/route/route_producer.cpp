@@ -26,6 +26,7 @@
 #include <common/timer.h>
 
 #include <core/frame/draw_frame.h>
+#include <core/frame/frame_timestamps.h>
 #include <core/monitor/monitor.h>
 #include <core/producer/frame_producer.h>
 #include <core/video_channel.h>
@@ -40,9 +41,17 @@ namespace caspar { namespace core {
 
 class route_producer : public frame_producer
 {
+    // A frame of the source channel and when it was handed over.
+    struct buffered_frame
+    {
+        core::draw_frame                      frame;
+        frame_timestamps::clock_t::time_point signalled;
+    };
+
     spl::shared_ptr<diagnostics::graph> graph_;
 
-    tbb::concurrent_bounded_queue<core::draw_frame> buffer_;
+    tbb::concurrent_bounded_queue<buffered_frame> buffer_;
+    latency_histogram                             latency_;
 
     caspar::timer produce_timer_;
     caspar::timer consume_timer_;
@@ -52,16 +61,20 @@ class route_producer : public frame_producer
 
     core::draw_frame frame_;
 
+    core::video_format_desc format_desc_;
+    double                  due_ = 0.0; // Source frames due, for channels running at another frame rate.
+
   public:
-    route_producer(std::shared_ptr<route> route, int buffer)
+    route_producer(std::shared_ptr<route> route, int buffer, const core::video_format_desc& format_desc)
         : route_(route)
         , connection_(route_->signal.connect([this](const core::draw_frame& frame) {
-            if (!buffer_.try_push(frame)) {
+            if (!buffer_.try_push(buffered_frame{frame, frame_timestamps::clock_t::now()})) {
                 graph_->set_tag(diagnostics::tag_severity::WARNING, "dropped-frame");
             }
             graph_->set_value("produce-time", produce_timer_.elapsed() * route_->format_desc.fps * 0.5);
             produce_timer_.restart();
         }))
+        , format_desc_(format_desc)
     {
         buffer_.set_capacity(buffer > 0 ? buffer : route->format_desc.field_count);
 
@@ -77,24 +90,52 @@ class route_producer : public frame_producer
 
     draw_frame last_frame() override
     {
-        if (!frame_) {
-            buffer_.try_pop(frame_);
+        buffered_frame buffered;
+        if (!frame_ && buffer_.try_pop(buffered)) {
+            frame_ = buffered.frame;
         }
         return core::draw_frame::still(frame_);
     }
 
     draw_frame receive_impl(int nb_samples) override
     {
-        core::draw_frame frame;
-        if (!buffer_.try_pop(frame)) {
-            graph_->set_tag(diagnostics::tag_severity::WARNING, "late-frame");
-        } else {
-            frame_ = frame;
-        }
-
         graph_->set_value("consume-time", consume_timer_.elapsed() * route_->format_desc.fps * 0.5);
         consume_timer_.restart();
-        return frame;
+
+        // A slower source repeats its last frame, a faster one has the frames in between skipped.
+        due_ += route_->format_desc.fps / format_desc_.fps;
+        if (due_ < 1.0) {
+            return core::draw_frame::still(frame_);
+        }
+
+        buffered_frame buffered;
+        bool           received = false;
+        while (due_ >= 1.0) {
+            due_ -= 1.0;
+            if (!buffer_.try_pop(buffered)) {
+                graph_->set_tag(diagnostics::tag_severity::WARNING, "late-frame");
+                due_ = 0.0;
+                break;
+            }
+            frame_   = buffered.frame;
+            received = true;
+            latency_.sample(buffered.signalled, frame_timestamps::clock_t::now() - buffered.signalled);
+        }
+
+        return received ? frame_ : core::draw_frame{};
+    }
+
+    void format_desc(const core::video_format_desc& format_desc) override
+    {
+        format_desc_ = format_desc;
+        due_         = 0.0;
+    }
+
+    core::monitor::state state() const override
+    {
+        core::monitor::state state;
+        state["latency"] = latency_.state(route_->format_desc.fps);
+        return state;
     }
 
     std::wstring print() const override { return L"route[" + route_->name + L"]"; }
@@ -133,7 +174,7 @@ spl::shared_ptr<core::frame_producer> create_route_producer(const core::frame_pr
 
     auto buffer = get_param(L"BUFFER", params, 0);
 
-    return spl::make_shared<route_producer>((*channel_it)->route(layer, mode), buffer);
+    return spl::make_shared<route_producer>((*channel_it)->route(layer, mode), buffer, dependencies.format_desc);
 }
 
 }} // namespace caspar::core
@@ -92,6 +92,12 @@ class separated_producer : public frame_producer
 
     uint32_t frame_number() const override { return fill_producer_->frame_number(); }
 
+    void format_desc(const video_format_desc& format_desc) override
+    {
+        fill_producer_->format_desc(format_desc);
+        key_producer_->format_desc(format_desc);
+    }
+
     uint32_t nb_frames() const override { return std::min(fill_producer_->nb_frames(), key_producer_->nb_frames()); }
 
     std::wstring print() const override
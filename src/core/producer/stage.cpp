@@ -25,10 +25,13 @@
 
 #include "layer.h"
 
+#include "../destroyer.h"
 #include "../frame/draw_frame.h"
 #include "../frame/frame_factory.h"
+#include "../video_format.h"
 
 #include <common/diagnostics/graph.h>
+#include <common/env.h>
 #include <common/executor.h>
 #include <common/future.h>
 #include <common/timer.h>
@@ -36,9 +39,12 @@
 #include <core/frame/frame_transform.h>
 
 #include <boost/lexical_cast.hpp>
+#include <boost/property_tree/ptree.hpp>
 #include <boost/range/adaptors.hpp>
 #include <boost/range/algorithm.hpp>
 
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <future>
 #include <map>
@@ -46,13 +52,36 @@
 
 namespace caspar { namespace core {
 
+// A layer and the thread it produces on. The layer is only touched from its own thread while a receive or an
+// operation queued behind a late receive is in flight, and from the stage thread otherwise.
+struct layer_worker
+{
+    core::layer                     layer;
+    std::shared_future<layer_frame> pending;
+    std::shared_future<void>        queued;
+    draw_frame                      last_frame;
+    bool                            has_background = false;
+    monitor::state                  state;
+    std::int64_t                    late = 0;
+    executor                        thread; // Declared last so that it is joined before the layer is destroyed.
+
+    explicit layer_worker(const std::wstring& name)
+        : thread(name)
+    {
+    }
+
+    bool idle() const { return (!pending.valid() || is_ready(pending)) && (!queued.valid() || is_ready(queued)); }
+};
+
 struct stage::impl : public std::enable_shared_from_this<impl>
 {
-    int                                 channel_index_;
-    spl::shared_ptr<diagnostics::graph> graph_;
-    monitor::state                      state_;
-    std::map<int, layer>                layers_;
-    std::map<int, tweened_transform>    tweens_;
+    int                                          channel_index_;
+    spl::shared_ptr<diagnostics::graph>          graph_;
+    monitor::state                               state_;
+    std::map<int, std::shared_ptr<layer_worker>> layers_;
+    std::map<int, tweened_transform>             tweens_;
+    const double                                 layer_deadline_;
+    std::atomic<bool>                            offline_{false};
 
     executor executor_{L"stage " + boost::lexical_cast<std::wstring>(channel_index_)};
 
@@ -60,7 +89,9 @@ struct stage::impl : public std::enable_shared_from_this<impl>
     impl(int channel_index, spl::shared_ptr<diagnostics::graph> graph)
         : channel_index_(channel_index)
         , graph_(std::move(graph))
+        , layer_deadline_(env::properties().get(L"configuration.stage.layer-deadline", 0.8))
     {
+        graph_->set_color("late-layer", diagnostics::color(0.9f, 0.6f, 0.2f));
     }
 
     std::map<int, layer_frame>
@@ -70,30 +101,77 @@ struct stage::impl : public std::enable_shared_from_this<impl>
             std::map<int, layer_frame> frames;
 
             try {
+                auto offline  = offline_.load();
+                auto deadline = std::chrono::steady_clock::now() +
+                                std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                    std::chrono::duration<double>(layer_deadline_ / format_desc.fps));
+
                 for (auto& t : tweens_)
                     t.second.tick(1);
 
+                // Every idle layer produces on its own thread, a layer still busy with an earlier tick is skipped.
+                for (auto& p : layers_) {
+                    auto& worker = *p.second;
+                    if (offline && worker.queued.valid()) {
+                        worker.queued.wait();
+                    }
+                    if (worker.pending.valid() || !worker.idle()) {
+                        continue;
+                    }
+
+                    auto layer      = &worker.layer;
+                    auto background = std::find(fetch_background.begin(), fetch_background.end(), p.first) !=
+                                      fetch_background.end();
+
+                    worker.pending = worker.thread
+                                         .begin_invoke([=] {
+                                             layer_frame res    = {};
+                                             res.foreground     = layer->receive(format_desc, nb_samples);
+                                             res.has_background = layer->has_background();
+                                             if (background) {
+                                                 res.background = layer->receive_background(format_desc, nb_samples);
+                                             }
+                                             return res;
+                                         })
+                                         .share();
+                }
+
+                // A layer which misses the deadline shows its last frame, its real frame is used on the next tick. An
+                // offline channel waits for every layer instead, so that no frame is repeated.
                 for (auto& p : layers_) {
-                    auto& layer = p.second;
-                    auto& tween = tweens_[p.first];
-
-                    layer_frame res    = {};
-                    res.foreground     = draw_frame::push(layer.receive(format_desc, nb_samples), tween.fetch());
-                    res.has_background = layer.has_background();
-                    if (std::find(fetch_background.begin(), fetch_background.end(), p.first) !=
-                        fetch_background.end()) {
-                        res.background = layer.receive_background(format_desc, nb_samples);
+                    auto& worker = *p.second;
+                    auto& tween  = tweens_[p.first];
+
+                    layer_frame res = {};
+                    if (worker.pending.valid() &&
+                        (offline || layer_deadline_ <= 0.0 ||
+                         worker.pending.wait_until(deadline) == std::future_status::ready)) {
+                        res            = worker.pending.get();
+                        worker.pending = {};
+
+                        worker.last_frame     = res.foreground;
+                        worker.has_background = res.has_background;
+                        worker.state          = worker.layer.state();
+                    } else {
+                        res.foreground     = draw_frame::still(worker.last_frame);
+                        res.has_background = worker.has_background;
+
+                        worker.late += 1;
+                        graph_->set_tag(diagnostics::tag_severity::WARNING, "late-layer");
                     }
+
+                    res.foreground  = draw_frame::push(res.foreground, tween.fetch());
                     frames[p.first] = res;
                 }
 
                 monitor::state state;
                 for (auto& p : layers_) {
-                    state["layer"][p.first] = p.second.state();
+                    state["layer"][p.first]         = p.second->state;
+                    state["layer"][p.first]["late"] = p.second->late;
                 }
                 state_ = std::move(state);
             } catch (...) {
-                layers_.clear();
+                clear_layers();
                 CASPAR_LOG_CURRENT_EXCEPTION();
             }
 
@@ -101,15 +179,72 @@ struct stage::impl : public std::enable_shared_from_this<impl>
         });
     }
 
-    layer& get_layer(int index)
+    std::shared_ptr<layer_worker>& get_worker(int index)
     {
         auto it = layers_.find(index);
         if (it == std::end(layers_)) {
-            it = layers_.emplace(index, layer()).first;
+            auto name = L"stage " + boost::lexical_cast<std::wstring>(channel_index_) + L" layer " +
+                        boost::lexical_cast<std::wstring>(index);
+            it = layers_.emplace(index, std::make_shared<layer_worker>(name)).first;
         }
         return it->second;
     }
 
+    // Runs func on the layer right away if it is idle, otherwise queues it behind the work in flight so that the stage
+    // never waits for a stalled producer.
+    void with_layer(int index, std::function<void(layer&)> func)
+    {
+        auto& worker = *get_worker(index);
+        if (worker.idle()) {
+            func(worker.layer);
+        } else {
+            auto layer    = &worker.layer;
+            worker.queued = worker.thread.begin_invoke([=] { func(*layer); }).share();
+        }
+    }
+
+    template <typename T, typename Func>
+    std::future<T> query_layer(int index, Func func)
+    {
+        auto promise = std::make_shared<std::promise<T>>();
+        with_layer(index, [=](layer& layer) {
+            try {
+                promise->set_value(func(layer));
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        });
+        return promise->get_future();
+    }
+
+    // A layer which is still busy is released on the destroyer, so that removing it does not wait for its producer.
+    void retire(std::shared_ptr<layer_worker> worker)
+    {
+        if (worker && !worker->idle()) {
+            destroyer::instance().destroy(L"stage " + boost::lexical_cast<std::wstring>(channel_index_) + L" layer",
+                                          std::move(worker));
+        }
+    }
+
+    void clear_layer(int index)
+    {
+        auto it = layers_.find(index);
+        if (it != layers_.end()) {
+            auto worker = std::move(it->second);
+            layers_.erase(it);
+            retire(std::move(worker));
+        }
+    }
+
+    void clear_layers()
+    {
+        auto layers = std::move(layers_);
+        layers_.clear();
+        for (auto& p : layers) {
+            retire(std::move(p.second));
+        }
+    }
+
     std::future<void>
     apply_transforms(const std::vector<std::tuple<int, stage::transform_func_t, unsigned int, tweener>>& transforms)
     {
@@ -151,39 +286,44 @@ struct stage::impl : public std::enable_shared_from_this<impl>
         return executor_.begin_invoke([=] { return tweens_[index].fetch(); });
     }
 
-    std::future<void> load(int index, const spl::shared_ptr<frame_producer>& producer, bool preview, bool auto_play)
+    std::future<void> load(int                                    index,
+                           const spl::shared_ptr<frame_producer>& producer,
+                           bool                                   preview,
+                           bool                                   auto_play,
+                           const std::vector<std::wstring>&       source)
     {
-        return executor_.begin_invoke([=] { get_layer(index).load(producer, preview, auto_play); });
+        return executor_.begin_invoke(
+            [=] { with_layer(index, [=](layer& layer) { layer.load(producer, preview, auto_play, source); }); });
     }
 
     std::future<void> pause(int index)
     {
-        return executor_.begin_invoke([=] { get_layer(index).pause(); });
+        return executor_.begin_invoke([=] { with_layer(index, [](layer& layer) { layer.pause(); }); });
     }
 
     std::future<void> resume(int index)
     {
-        return executor_.begin_invoke([=] { get_layer(index).resume(); });
+        return executor_.begin_invoke([=] { with_layer(index, [](layer& layer) { layer.resume(); }); });
     }
 
     std::future<void> play(int index)
     {
-        return executor_.begin_invoke([=] { get_layer(index).play(); });
+        return executor_.begin_invoke([=] { with_layer(index, [](layer& layer) { layer.play(); }); });
     }
 
     std::future<void> stop(int index)
     {
-        return executor_.begin_invoke([=] { get_layer(index).stop(); });
+        return executor_.begin_invoke([=] { with_layer(index, [](layer& layer) { layer.stop(); }); });
     }
 
     std::future<void> clear(int index)
     {
-        return executor_.begin_invoke([=] { layers_.erase(index); });
+        return executor_.begin_invoke([=] { clear_layer(index); });
     }
 
     std::future<void> clear()
     {
-        return executor_.begin_invoke([=] { layers_.clear(); });
+        return executor_.begin_invoke([=] { clear_layers(); });
     }
 
     std::future<void> swap_layers(stage& other, bool swap_transforms)
@@ -195,9 +335,6 @@ struct stage::impl : public std::enable_shared_from_this<impl>
         }
 
         auto func = [=] {
-            auto layers       = layers_ | boost::adaptors::map_values;
-            auto other_layers = other_impl->layers_ | boost::adaptors::map_values;
-
             std::swap(layers_, other_impl->layers_);
 
             if (swap_transforms)
@@ -210,7 +347,7 @@ struct stage::impl : public std::enable_shared_from_this<impl>
     std::future<void> swap_layer(int index, int other_index, bool swap_transforms)
     {
         return executor_.begin_invoke([=] {
-            std::swap(get_layer(index), get_layer(other_index));
+            std::swap(get_worker(index), get_worker(other_index));
 
             if (swap_transforms)
                 std::swap(tweens_[index], tweens_[other_index]);
@@ -225,8 +362,8 @@ struct stage::impl : public std::enable_shared_from_this<impl>
             return swap_layer(index, other_index, swap_transforms);
         else {
             auto func = [=] {
-                auto& my_layer    = get_layer(index);
-                auto& other_layer = other_impl->get_layer(other_index);
+                auto& my_layer    = get_worker(index);
+                auto& other_layer = other_impl->get_worker(other_index);
 
                 std::swap(my_layer, other_layer);
 
@@ -254,19 +391,84 @@ struct stage::impl : public std::enable_shared_from_this<impl>
 
     std::future<std::shared_ptr<frame_producer>> foreground(int index)
     {
-        return executor_.begin_invoke(
-            [=]() -> std::shared_ptr<frame_producer> { return get_layer(index).foreground(); });
+        return flatten(executor_.begin_invoke([=] {
+            return query_layer<std::shared_ptr<frame_producer>>(
+                index, [](layer& layer) -> std::shared_ptr<frame_producer> { return layer.foreground(); });
+        }));
     }
 
     std::future<std::shared_ptr<frame_producer>> background(int index)
     {
-        return executor_.begin_invoke(
-            [=]() -> std::shared_ptr<frame_producer> { return get_layer(index).background(); });
+        return flatten(executor_.begin_invoke([=] {
+            return query_layer<std::shared_ptr<frame_producer>>(
+                index, [](layer& layer) -> std::shared_ptr<frame_producer> { return layer.background(); });
+        }));
     }
 
     std::future<std::wstring> call(int index, const std::vector<std::wstring>& params)
     {
-        return flatten(executor_.begin_invoke([=] { return get_layer(index).foreground()->call(params).share(); }));
+        return flatten(flatten(executor_.begin_invoke([=] {
+            return query_layer<std::shared_future<std::wstring>>(
+                index, [=](layer& layer) { return layer.foreground()->call(params).share(); });
+        })));
+    }
+
+    std::future<std::map<int, layer_snapshot>> snapshot()
+    {
+        return flatten(executor_.begin_invoke([=] {
+            std::map<int, std::shared_future<layer_snapshot>> layers;
+
+            for (auto& p : layers_) {
+                layers[p.first] = query_layer<layer_snapshot>(p.first, [](layer& layer) {
+                                      layer_snapshot snapshot;
+                                      snapshot.foreground   = layer.foreground_source();
+                                      snapshot.background   = layer.background_source();
+                                      snapshot.frame_number = layer.foreground()->frame_number();
+                                      snapshot.paused       = layer.paused();
+                                      snapshot.auto_play    = layer.auto_play();
+                                      return snapshot;
+                                  }).share();
+            }
+
+            // Layers still busy with a late frame are waited for by the caller, not by the stage.
+            auto tweens = tweens_;
+            return std::async(std::launch::deferred, [=] {
+                std::map<int, layer_snapshot> result;
+                for (auto& p : layers) {
+                    result[p.first] = p.second.get();
+                }
+                for (auto& p : tweens) {
+                    result[p.first].transform = p.second;
+                }
+                return result;
+            });
+        }));
+    }
+
+    std::future<void> restore(const std::vector<stage::restore_tuple_t>& layers)
+    {
+        return executor_.begin_invoke([=] {
+            for (auto& t : layers) {
+                auto  index    = std::get<0>(t);
+                auto& snapshot = std::get<1>(t);
+
+                clear_layer(index);
+                auto& layer = get_worker(index)->layer;
+
+                if (std::get<2>(t) != frame_producer::empty()) {
+                    layer.load(std::get<2>(t), true, false, snapshot.foreground);
+                    if (!snapshot.paused) {
+                        layer.resume();
+                    }
+                }
+
+                if (std::get<3>(t) != frame_producer::empty()) {
+                    layer.load(std::get<3>(t), false, snapshot.auto_play, snapshot.background);
+                }
+
+                tweens_[index] = snapshot.transform;
+            }
+        });
     }
 };
 
@@ -292,9 +494,13 @@ std::future<void> stage::apply_transform(int
 std::future<void>            stage::clear_transforms(int index) { return impl_->clear_transforms(index); }
 std::future<void>            stage::clear_transforms() { return impl_->clear_transforms(); }
 std::future<frame_transform> stage::get_current_transform(int index) { return impl_->get_current_transform(index); }
-std::future<void> stage::load(int index, const spl::shared_ptr<frame_producer>& producer, bool preview, bool auto_play)
+std::future<void> stage::load(int                                    index,
+                              const spl::shared_ptr<frame_producer>& producer,
+                              bool                                   preview,
+                              bool                                   auto_play,
+                              const std::vector<std::wstring>&       source)
 {
-    return impl_->load(index, producer, preview, auto_play);
+    return impl_->load(index, producer, preview, auto_play, source);
 }
 std::future<void> stage::pause(int index) { return impl_->pause(index); }
 std::future<void> stage::resume(int index) { return impl_->resume(index); }
@@ -321,5 +527,8 @@ std::map<int, layer_frame>                   stage::
 {
     return (*impl_)(format_desc, nb_samples, fetch_background);
 }
-core::monitor::state stage::state() const { return impl_->state_; }
+std::future<void> stage::restore(const std::vector<restore_tuple_t>& layers) { return impl_->restore(layers); }
+void              stage::offline(bool enabled) { impl_->offline_ = enabled; }
+std::future<std::map<int, layer_snapshot>> stage::snapshot() { return impl_->snapshot(); }
+core::monitor::state                       stage::state() const { return impl_->state_; }
 }} // namespace caspar::core
@@ -29,10 +29,13 @@
 #include <common/tweener.h>
 
 #include <core/frame/draw_frame.h>
+#include <core/frame/frame_transform.h>
 
+#include <cstdint>
 #include <functional>
 #include <future>
 #include <map>
+#include <string>
 #include <tuple>
 #include <vector>
 
@@ -47,6 +50,18 @@ struct layer_frame
     bool       has_background;
 };
 
+// What is needed to bring a layer back: the parameters its producers were created from, where the foreground was
+// and its transform, including any tween in progress.
+struct layer_snapshot
+{
+    std::vector<std::wstring> foreground;
+    std::vector<std::wstring> background;
+    std::uint32_t             frame_number = 0;
+    bool                      paused       = false;
+    bool                      auto_play    = false;
+    tweened_transform         transform;
+};
+
 class stage final
 {
     stage(const stage&);
@@ -55,6 +70,9 @@ class stage final
   public:
     typedef std::function<struct frame_transform(struct frame_transform)> transform_func_t;
     typedef std::tuple<int, transform_func_t, unsigned int, tweener>      transform_tuple_t;
+    // Layer index, what to restore and the foreground and background producers created for it.
+    typedef std::tuple<int, layer_snapshot, spl::shared_ptr<frame_producer>, spl::shared_ptr<frame_producer>>
+        restore_tuple_t;
 
     explicit stage(int channel_index, spl::shared_ptr<caspar::diagnostics::graph> graph);
 
@@ -67,8 +85,11 @@ class stage final
     std::future<void>            clear_transforms(int index);
     std::future<void>            clear_transforms();
     std::future<frame_transform> get_current_transform(int index);
-    std::future<void>
-                              load(int index, const spl::shared_ptr<frame_producer>& producer, bool preview = false, bool auto_play = false);
+    std::future<void>         load(int                                    index,
+                                   const spl::shared_ptr<frame_producer>& producer,
+                                   bool                                   preview   = false,
+                                   bool                                   auto_play = false,
+                                   const std::vector<std::wstring>&       source    = {});
     std::future<void>         pause(int index);
     std::future<void>         resume(int index);
     std::future<void>         play(int index);
@@ -80,6 +101,15 @@ class stage final
     std::future<void>         swap_layer(int index, int other_index, bool swap_transforms);
     std::future<void>         swap_layer(int index, int other_index, stage& other, bool swap_transforms);
 
+    // Captures all layers between two ticks.
+    std::future<std::map<int, layer_snapshot>> snapshot();
+
+    // Replaces the given layers, all within the same tick.
+    std::future<void> restore(const std::vector<restore_tuple_t>& layers);
+
+    // Waits for every layer on each tick instead of showing the last frame of a late one.
+    void offline(bool enabled);
+
     core::monitor::state state() const;
 
     std::future<std::shared_ptr<frame_producer>> foreground(int index);
@@ -69,6 +69,14 @@ class sting_producer : public frame_producer
 
     void leading_producer(const spl::shared_ptr<frame_producer>& producer) override { src_producer_ = producer; }
 
+    void format_desc(const video_format_desc& format_desc) override
+    {
+        dst_producer_->format_desc(format_desc);
+        src_producer_->format_desc(format_desc);
+        mask_producer_->format_desc(format_desc);
+        overlay_producer_->format_desc(format_desc);
+    }
+
     spl::shared_ptr<frame_producer> following_producer() const override
     {
         auto duration = auto_play_delta();
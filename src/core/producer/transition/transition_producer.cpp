@@ -78,6 +78,12 @@ class transition_producer : public frame_producer
 
     boost::optional<int64_t> auto_play_delta() const override { return info_.duration; }
 
+    void format_desc(const video_format_desc& format_desc) override
+    {
+        dst_producer_->format_desc(format_desc);
+        src_producer_->format_desc(format_desc);
+    }
+
     void update_state()
     {
         state_                     = dst_producer_->state();
@@ -0,0 +1,476 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+
+#include "StdAfx.h"
+
+#include "snapshot.h"
+
+#include "frame/frame_transform.h"
+#include "mixer/image/blend_modes.h"
+#include "producer/frame_producer.h"
+#include "producer/stage.h"
+#include "video_channel.h"
+#include "video_format.h"
+
+#include <common/env.h>
+#include <common/except.h>
+#include <common/log.h>
+#include <common/os/thread.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace caspar { namespace core {
+
+namespace {
+
+typedef boost::property_tree::wptree wptree;
+
+struct snapshot_stats
+{
+    std::mutex   mutex;
+    std::int64_t saves            = 0;
+    std::int64_t failed_saves     = 0;
+    std::int64_t save_time        = 0;
+    double       save_duration    = 0.0;
+    std::int64_t restore_time     = 0;
+    int          restored_layers  = 0;
+    int          failed_layers    = 0;
+    double       restore_duration = 0.0;
+};
+
+snapshot_stats& stats()
+{
+    static snapshot_stats stats;
+    return stats;
+}
+
+std::int64_t now_ms()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+double seconds_since(std::chrono::steady_clock::time_point begin)
+{
+    return std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// Both directions of the transform serialization visit the same fields, so they can not drift apart.
+struct transform_writer
+{
+    wptree& pt;
+
+    template <typename T>
+    void operator()(const std::wstring& name, T& value)
+    {
+        pt.put(name, value);
+    }
+
+    void operator()(const std::wstring& name, std::array<double, 2>& value)
+    {
+        pt.put(name + L".x", value[0]);
+        pt.put(name + L".y", value[1]);
+    }
+
+    void operator()(const std::wstring& name, blend_mode& value) { pt.put(name, get_blend_mode(value)); }
+};
+
+struct transform_reader
+{
+    const wptree& pt;
+
+    template <typename T>
+    void operator()(const std::wstring& name, T& value)
+    {
+        value = pt.get(name, value);
+    }
+
+    void operator()(const std::wstring& name, std::array<double, 2>& value)
+    {
+        value[0] = pt.get(name + L".x", value[0]);
+        value[1] = pt.get(name + L".y", value[1]);
+    }
+
+    void operator()(const std::wstring& name, blend_mode& value)
+    {
+        value = get_blend_mode(pt.get(name, get_blend_mode(value)));
+    }
+};
+
+template <typename Visitor>
+void visit_transform(Visitor& visit, frame_transform& transform)
+{
+    auto& image = transform.image_transform;
+
+    visit(L"opacity", image.opacity);
+    visit(L"contrast", image.contrast);
+    visit(L"brightness", image.brightness);
+    visit(L"saturation", image.saturation);
+    visit(L"anchor", image.anchor);
+    visit(L"fill-translation", image.fill_translation);
+    visit(L"fill-scale", image.fill_scale);
+    visit(L"clip-translation", image.clip_translation);
+    visit(L"clip-scale", image.clip_scale);
+    visit(L"angle", image.angle);
+    visit(L"crop.ul", image.crop.ul);
+    visit(L"crop.lr", image.crop.lr);
+    visit(L"perspective.ul", image.perspective.ul);
+    visit(L"perspective.ur", image.perspective.ur);
+    visit(L"perspective.lr", image.perspective.lr);
+    visit(L"perspective.ll", image.perspective.ll);
+    visit(L"levels.min-input", image.levels.min_input);
+    visit(L"levels.max-input", image.levels.max_input);
+    visit(L"levels.gamma", image.levels.gamma);
+    visit(L"levels.min-output", image.levels.min_output);
+    visit(L"levels.max-output", image.levels.max_output);
+    visit(L"chroma.enable", image.chroma.enable);
+    visit(L"chroma.show-mask", image.chroma.show_mask);
+    visit(L"chroma.target-hue", image.chroma.target_hue);
+    visit(L"chroma.hue-width", image.chroma.hue_width);
+    visit(L"chroma.min-saturation", image.chroma.min_saturation);
+    visit(L"chroma.min-brightness", image.chroma.min_brightness);
+    visit(L"chroma.softness", image.chroma.softness);
+    visit(L"chroma.spill-suppress", image.chroma.spill_suppress);
+    visit(L"chroma.spill-suppress-saturation", image.chroma.spill_suppress_saturation);
+    visit(L"is-key", image.is_key);
+    visit(L"invert", image.invert);
+    visit(L"is-mix", image.is_mix);
+    visit(L"blend-mode", image.blend_mode);
+    visit(L"layer-depth", image.layer_depth);
+    visit(L"volume", transform.audio_transform.volume);
+}
+
+wptree to_ptree(frame_transform transform)
+{
+    wptree           pt;
+    transform_writer writer{pt};
+    visit_transform(writer, transform);
+    return pt;
+}
+
+frame_transform from_ptree(const wptree& pt)
+{
+    frame_transform  transform;
+    transform_reader reader{pt};
+    visit_transform(reader, transform);
+    return transform;
+}
+
+void put_params(wptree& pt, const std::wstring& name, const std::vector<std::wstring>& params)
+{
+    auto& xml_params = pt.add_child(name, wptree());
+    for (auto& param : params)
+        xml_params.add(L"param", param);
+}
+
+std::vector<std::wstring> get_params(const wptree& pt, const std::wstring& name)
+{
+    std::vector<std::wstring> params;
+    if (auto xml_params = pt.get_child_optional(name)) {
+        for (auto& param : *xml_params)
+            params.push_back(param.second.get_value<std::wstring>());
+    }
+    return params;
+}
+
+wptree to_ptree(const layer_snapshot& layer)
+{
+    wptree pt;
+
+    put_params(pt, L"foreground", layer.foreground);
+    put_params(pt, L"background", layer.background);
+    pt.put(L"frame", layer.frame_number);
+    pt.put(L"paused", layer.paused);
+    pt.put(L"auto-play", layer.auto_play);
+    pt.put(L"transform.duration", layer.transform.duration());
+    pt.put(L"transform.time", layer.transform.time());
+    pt.put(L"transform.tween", layer.transform.tween().name());
+    pt.add_child(L"transform.source", to_ptree(layer.transform.source()));
+    pt.add_child(L"transform.dest", to_ptree(layer.transform.dest()));
+
+    return pt;
+}
+
+layer_snapshot layer_from_ptree(const wptree& pt)
+{
+    layer_snapshot layer;
+
+    layer.foreground   = get_params(pt, L"foreground");
+    layer.background   = get_params(pt, L"background");
+    layer.frame_number = pt.get(L"frame", 0U);
+    layer.paused       = pt.get(L"paused", false);
+    layer.auto_play    = pt.get(L"auto-play", false);
+
+    layer.transform = tweened_transform(from_ptree(pt.get_child(L"transform.source", wptree())),
+                                        from_ptree(pt.get_child(L"transform.dest", wptree())),
+                                        pt.get(L"transform.duration", 0),
+                                        tweener(pt.get(L"transform.tween", L"linear")));
+    layer.transform.tick(pt.get(L"transform.time", 0));
+
+    return layer;
+}
+
+bool is_empty(const layer_snapshot& layer)
+{
+    return layer.foreground.empty() && layer.background.empty() && layer.transform.source() == frame_transform() &&
+           layer.transform.dest() == frame_transform();
+}
+
+} // namespace
+
+std::wstring snapshot_path()
+{
+    return env::data_folder() + env::properties().get(L"configuration.snapshot.path", L"snapshot.xml");
+}
+
+void save_snapshot(const std::vector<spl::shared_ptr<video_channel>>& channels, const std::wstring& path)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    try {
+        std::vector<std::future<std::map<int, layer_snapshot>>> layers;
+        for (auto& channel : channels)
+            layers.push_back(channel->stage().snapshot());
+
+        wptree pt;
+        pt.put(L"snapshot.time", now_ms());
+
+        for (std::size_t n = 0; n < channels.size(); ++n) {
+            auto& xml_channel = pt.add_child(L"snapshot.channels.channel", wptree());
+            xml_channel.put(L"index", channels[n]->index());
+            xml_channel.put(L"video-mode", channels[n]->video_format_desc().name);
+
+            auto& xml_layers = xml_channel.add_child(L"layers", wptree());
+            for (auto& layer : layers[n].get()) {
+                if (is_empty(layer.second))
+                    continue;
+
+                auto& xml_layer = xml_layers.add_child(L"layer", to_ptree(layer.second));
+                xml_layer.put(L"index", layer.first);
+            }
+        }
+
+        // Written next to the previous snapshot and then renamed over it, so a crash while writing never leaves a
+        // partial file behind.
+        auto temp_path = path + L".tmp";
+        {
+            boost::filesystem::wofstream file(temp_path);
+            if (!file)
+                CASPAR_THROW_EXCEPTION(caspar_exception() << msg_info(L"Could not open file " + temp_path));
+
+            boost::property_tree::write_xml(file, pt, boost::property_tree::xml_writer_settings<std::wstring>(' ', 2));
+        }
+        boost::filesystem::rename(temp_path, path);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(stats().mutex);
+        stats().failed_saves += 1;
+        throw;
+    }
+
+    std::lock_guard<std::mutex> lock(stats().mutex);
+    stats().saves += 1;
+    stats().save_time     = now_ms();
+    stats().save_duration = seconds_since(begin);
+}
+
+double restore_snapshot(const std::wstring&                                   path,
+                        const std::vector<spl::shared_ptr<video_channel>>&    channels,
+                        const spl::shared_ptr<const frame_producer_registry>& producer_registry,
+                        const spl::shared_ptr<const cg_producer_registry>&    cg_registry)
+{
+    auto begin = std::chrono::steady_clock::now();
+
+    wptree pt;
+    {
+        boost::filesystem::wifstream file(path);
+        if (!file)
+            CASPAR_THROW_EXCEPTION(file_not_found() << msg_info(L"Could not open snapshot " + path));
+
+        boost::property_tree::read_xml(file, pt, boost::property_tree::xml_parser::trim_whitespace);
+    }
+
+    auto elapsed = std::max(0.0, (now_ms() - pt.get(L"snapshot.time", now_ms())) / 1000.0);
+
+    std::map<int, std::vector<std::future<stage::restore_tuple_t>>> pending;
+    std::atomic<int>                                                 failed{0};
+
+    for (auto& xml_channel : pt.get_child(L"snapshot.channels", wptree())) {
+        auto channel_index = xml_channel.second.get(L"index", 0);
+        if (channel_index < 1 || channel_index > static_cast<int>(channels.size())) {
+            CASPAR_LOG(warning) << L"[snapshot] Channel " << channel_index << L" does not exist, skipping it.";
+            continue;
+        }
+        auto channel = channels.at(channel_index - 1);
+
+        for (auto& xml_layer : xml_channel.second.get_child(L"layers", wptree())) {
+            auto index    = xml_layer.second.get(L"index", 0);
+            auto snapshot = layer_from_ptree(xml_layer.second);
+
+            pending[channel_index].push_back(std::async(std::launch::async, [=, &failed] {
+                frame_producer_dependencies dependencies(
+                    channel->frame_factory(), channels, channel->video_format_desc(), producer_registry, cg_registry);
+                dependencies.offline = channel->offline_flag();
+
+                auto foreground = frame_producer::empty();
+                auto background = frame_producer::empty();
+
+                try {
+                    if (!snapshot.foreground.empty()) {
+                        foreground = producer_registry->create_producer(dependencies, snapshot.foreground);
+
+                        auto frame = static_cast<std::int64_t>(snapshot.frame_number);
+                        if (!snapshot.paused)
+                            frame += std::llround(elapsed * channel->video_format_desc().fps);
+
+                        if (frame > 0) {
+                            try {
+                                foreground->call({L"SEEK", L"REL", std::to_wstring(frame)}).get();
+                            } catch (...) {
+                                CASPAR_LOG(warning) << L"[snapshot] " << foreground->print() << L" cannot seek.";
+                            }
+                        }
+                    }
+
+                    if (!snapshot.background.empty())
+                        background = producer_registry->create_producer(dependencies, snapshot.background);
+                } catch (...) {
+                    CASPAR_LOG_CURRENT_EXCEPTION();
+                    failed += 1;
+                }
+
+                return stage::restore_tuple_t(index, snapshot, foreground, background);
+            }));
+        }
+    }
+
+    int                            nb_layers = 0;
+    std::vector<std::future<void>> restored;
+    for (auto& p : pending) {
+        std::vector<stage::restore_tuple_t> layers;
+        for (auto& layer : p.second)
+            layers.push_back(layer.get());
+
+        nb_layers += static_cast<int>(layers.size());
+        restored.push_back(channels.at(p.first - 1)->stage().restore(layers));
+    }
+    for (auto& f : restored)
+        f.get();
+
+    auto time_to_air = seconds_since(begin);
+
+    CASPAR_LOG(info) << L"[snapshot] Restored " << nb_layers << L" layers (" << failed << L" failed) from " << path
+                     << L" in " << static_cast<int>(time_to_air * 1000) << L" ms.";
+
+    std::lock_guard<std::mutex> lock(stats().mutex);
+    stats().restore_time     = now_ms();
+    stats().restored_layers  = nb_layers;
+    stats().failed_layers    = failed;
+    stats().restore_duration = time_to_air;
+
+    return time_to_air;
+}
+
+monitor::state snapshot_state()
+{
+    std::lock_guard<std::mutex> lock(stats().mutex);
+
+    monitor::state state;
+    state["save/count"]          = stats().saves;
+    state["save/failed"]         = stats().failed_saves;
+    state["save/time"]           = stats().save_time;
+    state["save/duration"]       = stats().save_duration;
+    state["restore/time"]        = stats().restore_time;
+    state["restore/layers"]      = stats().restored_layers;
+    state["restore/failed"]      = stats().failed_layers;
+    state["restore/time-to-air"] = stats().restore_duration;
+    return state;
+}
+
+struct snapshot_writer::impl
+{
+    const std::vector<spl::shared_ptr<video_channel>> channels_;
+    const std::wstring                                path_;
+    const std::chrono::milliseconds                   interval_;
+
+    std::mutex              mutex_;
+    std::condition_variable cond_;
+    bool                    stopped_ = false;
+    std::thread             thread_;
+
+    impl(std::vector<spl::shared_ptr<video_channel>> channels, std::wstring path, int interval_ms)
+        : channels_(std::move(channels))
+        , path_(std::move(path))
+        , interval_(interval_ms)
+    {
+        thread_ = std::thread([this] {
+            set_thread_name(L"Snapshot writer");
+            run();
+        });
+    }
+
+    ~impl()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopped_ = true;
+        }
+        cond_.notify_all();
+        thread_.join();
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        while (!cond_.wait_for(lock, interval_, [this] { return stopped_; })) {
+            lock.unlock();
+            try {
+                save_snapshot(channels_, path_);
+            } catch (...) {
+                CASPAR_LOG_CURRENT_EXCEPTION();
+            }
+            lock.lock();
+        }
+    }
+};
+
+snapshot_writer::snapshot_writer(std::vector<spl::shared_ptr<video_channel>> channels,
+                                 std::wstring                                path,
+                                 int                                         interval_ms)
+    : impl_(new impl(std::move(channels), std::move(path), interval_ms))
+{
+}
+
+snapshot_writer::~snapshot_writer() {}
+
+}} // namespace caspar::core
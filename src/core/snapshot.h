@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+
+#pragma once
+
+#include "fwd.h"
+#include "monitor/monitor.h"
+
+#include <common/memory.h>
+
+#include <string>
+#include <vector>
+
+namespace caspar { namespace core {
+
+/**
+ * Writes the layers of all channels to a file at a fixed interval, so that a
+ * restarted server can bring them back with restore_snapshot(). Capturing costs
+ * each stage a single task between two ticks, serializing and writing happen
+ * on the writer's own thread.
+ */
+class snapshot_writer final
+{
+    snapshot_writer(const snapshot_writer&);
+    snapshot_writer& operator=(const snapshot_writer&);
+
+  public:
+    snapshot_writer(std::vector<spl::shared_ptr<video_channel>> channels, std::wstring path, int interval_ms);
+    ~snapshot_writer();
+
+  private:
+    struct impl;
+    spl::unique_ptr<impl> impl_;
+};
+
+/**
+ * @return configuration.snapshot.path, relative to the data folder.
+ */
+std::wstring snapshot_path();
+
+/**
+ * Captures the layers of all channels and writes them to path.
+ */
+void save_snapshot(const std::vector<spl::shared_ptr<video_channel>>& channels, const std::wstring& path);
+
+/**
+ * Recreates the layers written by save_snapshot(). The producers of all layers
+ * are created and seeked in parallel and each channel then gets all of its
+ * layers within the same tick. Layers which were playing are moved forward by
+ * the time passed since the snapshot was taken.
+ *
+ * @return The seconds from the call until all layers were handed to their
+ *         stages, i.e. on air from the next frame.
+ */
+double restore_snapshot(const std::wstring&                                   path,
+                        const std::vector<spl::shared_ptr<video_channel>>&    channels,
+                        const spl::shared_ptr<const frame_producer_registry>& producer_registry,
+                        const spl::shared_ptr<const cg_producer_registry>&    cg_registry);
+
+monitor::state snapshot_state();
+
+}} // namespace caspar::core
@@ -44,6 +44,8 @@
 
 #include <boost/lexical_cast.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -79,6 +81,19 @@ struct video_channel::impl final
     std::map<route_id, std::weak_ptr<core::route>> routes_;
     std::mutex                                     routes_mutex_;
 
+    latency_histogram produce_latency_;
+    latency_histogram mix_latency_;
+
+    const std::shared_ptr<std::atomic<bool>> offline_ = std::make_shared<std::atomic<bool>>(false);
+
+    typedef std::chrono::steady_clock switch_clock_t;
+
+    core::video_format_desc    last_format_desc_ = format_desc_; // Of the last tick.
+    switch_clock_t::time_point format_requested_;
+    std::int64_t               format_switches_   = 0;
+    double                     format_switch_     = 0.0; // Seconds from the request until the consumers were ready.
+    double                     format_switch_max_ = 0.0;
+
     std::atomic<bool> abort_request_{false};
     std::thread       thread_;
 
@@ -113,14 +128,17 @@ struct video_channel::impl final
 
             while (!abort_request_) {
                 try {
-                    core::video_format_desc format_desc;
-                    int                     nb_samples;
+                    core::video_format_desc    format_desc;
+                    int                        nb_samples;
+                    switch_clock_t::time_point format_requested;
                     {
                         std::lock_guard<std::mutex> lock(format_desc_mutex_);
                         format_desc = format_desc_;
                         boost::range::rotate(audio_cadence_, std::end(audio_cadence_) - 1);
-                        nb_samples = audio_cadence_.front();
+                        nb_samples       = audio_cadence_.front();
+                        format_requested = format_requested_;
                     }
+                    auto format_switch = format_desc != last_format_desc_;
 
                     caspar::timer frame_timer;
 
@@ -156,11 +174,25 @@ struct video_channel::impl final
                     auto mixed_frame = mixer_(frames, format_desc, format_desc.audio_cadence[0]);
                     graph_->set_value("mix-time", mix_timer.elapsed() * format_desc.fps * 0.5);
 
+                    auto& timestamps = mixed_frame.timestamps();
+                    produce_latency_.sample(timestamps.created, timestamps.produced - timestamps.created);
+                    mix_latency_.sample(timestamps.created, timestamps.mixed - timestamps.produced);
+
                     // Consume
                     caspar::timer consume_timer;
                     output_(std::move(mixed_frame), format_desc);
                     graph_->set_value("consume-time", consume_timer.elapsed() * format_desc.fps * 0.5);
 
+                    if (format_switch) {
+                        format_switch_ =
+                            std::chrono::duration<double>(switch_clock_t::now() - format_requested).count();
+                        format_switch_max_ = std::max(format_switch_max_, format_switch_);
+                        format_switches_ += 1;
+                        last_format_desc_ = format_desc;
+
+                        CASPAR_LOG(info) << print() << L" Switched format in " << format_switch_ * 1000.0 << L" ms.";
+                    }
+
                     graph_->set_value("frame-time", frame_timer.elapsed() * format_desc.fps * 0.5);
 
                     {
@@ -197,7 +229,15 @@ struct video_channel::impl final
                     state["mixer"]       = mixer_.state();
                     state["output"]      = output_.state();
                     state["framerate"]   = {format_desc_.framerate.numerator(), format_desc_.framerate.denominator()};
-                    state_               = state;
+                    state["offline"]     = offline_->load();
+
+                    state["format/switches"]   = format_switches_;
+                    state["format/switch"]     = format_switch_;
+                    state["format/switch-max"] = format_switch_max_;
+
+                    state["latency"]["produce"] = produce_latency_.state(format_desc.fps);
+                    state["latency"]["mix"]     = mix_latency_.state(format_desc.fps);
+                    state_                      = state;
 
                     caspar::timer osc_timer;
                     tick_(state_);
@@ -249,12 +289,29 @@ struct video_channel::impl final
         return format_desc_;
     }
 
+    // Takes effect with the next tick. The layers stay loaded and reconfigure their producers on their own threads,
+    // the output reinitializes its consumers.
     void video_format_desc(const core::video_format_desc& format_desc)
     {
         std::lock_guard<std::mutex> lock(format_desc_mutex_);
-        format_desc_   = format_desc;
-        audio_cadence_ = format_desc_.audio_cadence;
-        stage_.clear();
+        if (format_desc_ == format_desc) {
+            return;
+        }
+        format_desc_      = format_desc;
+        audio_cadence_    = format_desc_.audio_cadence;
+        format_requested_ = switch_clock_t::now();
+    }
+
+    void offline(bool enabled)
+    {
+        if (offline_->exchange(enabled) == enabled) {
+            return;
+        }
+
+        stage_.offline(enabled);
+        output_.offline(enabled);
+
+        CASPAR_LOG(info) << print() << (enabled ? L" Offline." : L" Realtime.");
     }
 
     std::wstring print() const
@@ -285,9 +342,13 @@ void                           core::video_channel::video_format_desc(const core
 {
     impl_->video_format_desc(format_desc);
 }
+void                 video_channel::offline(bool enabled) { impl_->offline(enabled); }
+bool                 video_channel::offline() const { return *impl_->offline_; }
 int                  video_channel::index() const { return impl_->index(); }
 core::monitor::state video_channel::state() const { return impl_->state_; }
 
+std::shared_ptr<const std::atomic<bool>> video_channel::offline_flag() const { return impl_->offline_; }
+
 std::shared_ptr<route> video_channel::route(int index, route_mode mode) { return impl_->route(index, mode); }
 
 }} // namespace caspar::core
@@ -31,7 +31,9 @@
 
 #include <boost/signals2.hpp>
 
+#include <atomic>
 #include <functional>
+#include <memory>
 
 namespace caspar { namespace core {
 
@@ -90,6 +92,19 @@ class video_channel final
 
     spl::shared_ptr<core::frame_factory> frame_factory();
 
+    /**
+     * Renders as fast as the consumers take the frames instead of in real
+     * time. Every layer delivers every frame, and file producers wait for
+     * their decoders instead of underflowing while the channel is offline.
+     */
+    void offline(bool enabled);
+    bool offline() const;
+
+    /**
+     * The offline state, for producers to check on every frame.
+     */
+    std::shared_ptr<const std::atomic<bool>> offline_flag() const;
+
     int index() const;
 
     std::shared_ptr<core::route> route(int index = -1, route_mode mode = route_mode::foreground);
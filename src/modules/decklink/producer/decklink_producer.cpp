@@ -50,6 +50,7 @@
 
 #include <boost/algorithm/string.hpp>
 #include <boost/circular_buffer.hpp>
+#include <boost/optional.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/range/adaptor/transformed.hpp>
 
@@ -77,6 +78,7 @@ extern "C" {
 #include "../decklink_api.h"
 
 #include <functional>
+#include <mutex>
 
 using namespace caspar::ffmpeg;
 
@@ -339,6 +341,9 @@ class decklink_producer : public IDeckLinkInputCallback
     Filter video_filter_;
     Filter audio_filter_;
 
+    std::mutex                               format_mutex_;
+    boost::optional<core::video_format_desc> format_request_;
+
   public:
     decklink_producer(const core::video_format_desc&              format_desc,
                       int                                         device_index,
@@ -502,6 +507,8 @@ class decklink_producer : public IDeckLinkInputCallback
         };
 
         try {
+            update_format();
+
             graph_->set_value("tick-time", tick_timer_.elapsed() * format_desc_.fps * 0.5);
             tick_timer_.restart();
 
@@ -648,6 +655,36 @@ class decklink_producer : public IDeckLinkInputCallback
         return S_OK;
     }
 
+    // The channel switched format. The filters are rebuilt for it on the input thread with the next frame.
+    void format_desc(const core::video_format_desc& format_desc)
+    {
+        std::lock_guard<std::mutex> lock(format_mutex_);
+        format_request_ = format_desc;
+    }
+
+    void update_format()
+    {
+        boost::optional<core::video_format_desc> request;
+        {
+            std::lock_guard<std::mutex> lock(format_mutex_);
+            request.swap(format_request_);
+        }
+
+        if (!request || *request == format_desc_) {
+            return;
+        }
+
+        CASPAR_LOG(info) << print() << L" Channel format changed from " << format_desc_.name << L" to "
+                         << request->name;
+
+        format_desc_   = *request;
+        audio_cadence_ = format_desc_.audio_cadence;
+        boost::range::rotate(audio_cadence_, std::end(audio_cadence_) - 1);
+
+        video_filter_ = Filter(vfilter_, AVMEDIA_TYPE_VIDEO, format_desc_, mode_);
+        audio_filter_ = Filter(afilter_, AVMEDIA_TYPE_AUDIO, format_desc_, mode_);
+    }
+
     core::draw_frame get_frame()
     {
         if (exception_ != nullptr) {
@@ -733,6 +770,8 @@ class decklink_producer_proxy : public core::frame_producer
 
     std::wstring name() const override { return L"decklink"; }
 
+    void format_desc(const core::video_format_desc& format_desc) override { producer_->format_desc(format_desc); }
+
     boost::rational<int> get_out_framerate() const { return producer_->get_out_framerate(); }
 };
 
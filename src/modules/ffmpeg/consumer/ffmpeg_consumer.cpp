@@ -72,6 +72,8 @@ extern "C" {
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_invoke.h>
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <thread>
 
@@ -454,6 +456,7 @@ struct ffmpeg_consumer : public core::frame_consumer
     int                     channel_index_ = -1;
     core::video_format_desc format_desc_;
     bool                    realtime_ = false;
+    std::atomic<bool>       offline_{false};
 
     spl::shared_ptr<diagnostics::graph> graph_;
 
@@ -691,7 +694,19 @@ struct ffmpeg_consumer : public core::frame_consumer
             }
         }
 
-        if (!frame_buffer_.try_push(frame)) {
+        if (offline_ && !realtime_) {
+            // Waiting for the encoder is what paces an offline channel. The exception is polled for so that an
+            // encoder which gave up does not block the channel.
+            while (!frame_buffer_.try_push(frame)) {
+                {
+                    std::lock_guard<std::mutex> lock(exception_mutex_);
+                    if (exception_ != nullptr) {
+                        std::rethrow_exception(exception_);
+                    }
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        } else if (!frame_buffer_.try_push(frame)) {
             graph_->set_tag(diagnostics::tag_severity::WARNING, "dropped-frame");
         }
         graph_->set_value("input", (static_cast<double>(frame_buffer_.size() + 0.001) / frame_buffer_.capacity()));
@@ -705,6 +720,8 @@ struct ffmpeg_consumer : public core::frame_consumer
 
     bool has_synchronization_clock() const override { return false; }
 
+    void offline(bool enabled) override { offline_ = enabled; }
+
     int index() const override { return 100000 + channel_index_; }
 
     core::monitor::state state() const override
@@ -0,0 +1,232 @@
+#include "av_frame_cache.h"
+
+#include "av_producer.h"
+
+#include <common/env.h>
+#include <common/executor.h>
+#include <common/log.h>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace caspar { namespace ffmpeg {
+
+struct AVFrameCache::Impl
+{
+    struct Worker
+    {
+        std::shared_ptr<AVProducer> producer;
+        std::unique_ptr<executor>   queue;
+    };
+
+    const core::video_format_desc format_desc_;
+    const int64_t                 chunk_size_;
+    const std::size_t             capacity_;
+
+    mutable std::mutex                                     mutex_;
+    std::map<int64_t, std::map<int64_t, core::draw_frame>> chunks_; // Frames by time, by chunk.
+    std::set<int64_t>                                      pending_;
+    std::size_t                                            size_   = 0;
+    int64_t                                                hits_   = 0;
+    int64_t                                                misses_ = 0;
+    int64_t                                                end_    = std::numeric_limits<int64_t>::max();
+
+    std::atomic<bool>   abort_{false};
+    std::vector<Worker> workers_;
+
+    Impl(std::shared_ptr<core::frame_factory> frame_factory,
+         core::video_format_desc              format_desc,
+         std::string                          name,
+         std::string                          path,
+         boost::optional<std::string>         vfilter,
+         boost::optional<std::string>         afilter)
+        : format_desc_(format_desc)
+        , chunk_size_(std::max<int64_t>(
+              1,
+              static_cast<int64_t>(std::round(env::properties().get(L"ffmpeg.producer.cache-chunk", 1.0) *
+                                              format_desc.fps))))
+        , capacity_(std::max<std::size_t>(2 * chunk_size_,
+                                          env::properties().get(L"ffmpeg.producer.cache-size", 512) * 1024ULL *
+                                              1024ULL / std::max<std::size_t>(1, format_desc.size)))
+    {
+        const auto count = std::max(1, std::min(env::properties().get(L"ffmpeg.producer.cache-threads", 2), 8));
+        for (int n = 0; n < count; ++n) {
+            Worker worker;
+            worker.producer = std::make_shared<AVProducer>(
+                frame_factory, format_desc, name, path, vfilter, afilter, boost::none, boost::none, false);
+            worker.queue = std::make_unique<executor>(L"ffmpeg cache " + boost::lexical_cast<std::wstring>(n));
+            workers_.push_back(std::move(worker));
+        }
+    }
+
+    ~Impl()
+    {
+        abort_ = true;
+        for (auto& worker : workers_) {
+            worker.queue->clear();
+        }
+    }
+
+    int64_t chunk(int64_t time) const
+    {
+        return time >= 0 ? time / chunk_size_ : (time - chunk_size_ + 1) / chunk_size_;
+    }
+
+    core::draw_frame get(int64_t time, double speed)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        core::draw_frame result;
+
+        auto it = chunks_.find(chunk(time));
+        if (it != chunks_.end()) {
+            auto it2 = it->second.find(time);
+            if (it2 != it->second.end()) {
+                result = it2->second;
+            }
+        }
+        if (result) {
+            hits_ += 1;
+        } else {
+            misses_ += 1;
+        }
+
+        schedule(time, speed < 0.0 ? -1 : 1, std::abs(speed));
+        evict(time);
+
+        return result;
+    }
+
+    // Called with mutex_ held. Keeps the chunk at time and the following ones in direction decoded or decoding, one
+    // per worker and as many more as the speed skips over.
+    void schedule(int64_t time, int direction, double speed)
+    {
+        const auto ahead = static_cast<int64_t>(workers_.size()) + static_cast<int64_t>(std::ceil(speed));
+        const auto first = chunk(time);
+
+        for (int64_t n = 0; n < ahead; ++n) {
+            const auto index = first + n * direction;
+            if (index < 0 || index * chunk_size_ >= end_) {
+                break;
+            }
+            if (chunks_.count(index) || pending_.count(index)) {
+                continue;
+            }
+
+            auto worker = std::min_element(workers_.begin(), workers_.end(), [](const Worker& a, const Worker& b) {
+                return a.queue->size() < b.queue->size();
+            });
+            if (worker->queue->size() > 1) {
+                break;
+            }
+
+            pending_.insert(index);
+            auto producer = worker->producer;
+            worker->queue->begin_invoke([=] { decode(*producer, index); });
+        }
+    }
+
+    // Runs on a worker.
+    void decode(AVProducer& producer, int64_t index)
+    {
+        const auto from = index * chunk_size_;
+
+        producer.seek(from);
+
+        std::map<int64_t, core::draw_frame> frames;
+        auto                                last = std::numeric_limits<int64_t>::min();
+        while (!abort_) {
+            // Offline, next_frame() waits for the decoder instead of returning nothing.
+            auto frame = producer.next_frame(true);
+            if (!frame) {
+                break;
+            }
+
+            // At the end the last frame is repeated, with the time after it.
+            const auto time = producer.time();
+            if (time == last) {
+                frames.erase(time);
+
+                std::lock_guard<std::mutex> lock(mutex_);
+                end_ = std::min(end_, time);
+                break;
+            }
+            last = time;
+
+            if (time >= from + chunk_size_) {
+                break;
+            }
+            if (time >= from) {
+                frames[time] = frame;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.erase(index);
+        if (!frames.empty()) {
+            size_ += frames.size();
+            chunks_[index] = std::move(frames);
+        }
+    }
+
+    // Called with mutex_ held. Drops the chunks furthest from time until the cache is within its budget.
+    void evict(int64_t time)
+    {
+        const auto current = chunk(time);
+        while (size_ > capacity_ && chunks_.size() > 1) {
+            auto furthest = std::max_element(chunks_.begin(), chunks_.end(), [&](const auto& a, const auto& b) {
+                return std::abs(a.first - current) < std::abs(b.first - current);
+            });
+            size_ -= furthest->second.size();
+            chunks_.erase(furthest);
+        }
+    }
+
+    core::monitor::state state() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        core::monitor::state state;
+        state["cache/frames"]    = static_cast<int64_t>(size_);
+        state["cache/capacity"]  = static_cast<int64_t>(capacity_);
+        state["cache/bytes"]     = static_cast<int64_t>(size_ * format_desc_.size);
+        state["cache/chunks"]    = static_cast<int64_t>(chunks_.size());
+        state["cache/pending"]   = static_cast<int64_t>(pending_.size());
+        state["cache/hits"]      = hits_;
+        state["cache/misses"]    = misses_;
+        state["cache/hit-ratio"] = hits_ + misses_ > 0 ? static_cast<double>(hits_) / (hits_ + misses_) : 0.0;
+        return state;
+    }
+};
+
+AVFrameCache::AVFrameCache(std::shared_ptr<core::frame_factory> frame_factory,
+                           core::video_format_desc              format_desc,
+                           std::string                          name,
+                           std::string                          path,
+                           boost::optional<std::string>         vfilter,
+                           boost::optional<std::string>         afilter)
+    : impl_(new Impl(std::move(frame_factory),
+                     std::move(format_desc),
+                     std::move(name),
+                     std::move(path),
+                     std::move(vfilter),
+                     std::move(afilter)))
+{
+}
+
+AVFrameCache::~AVFrameCache() {}
+
+core::draw_frame AVFrameCache::get(int64_t time, double speed) { return impl_->get(time, speed); }
+
+core::monitor::state AVFrameCache::state() const { return impl_->state(); }
+
+}} // namespace caspar::ffmpeg
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <core/frame/draw_frame.h>
+#include <core/frame/frame_factory.h>
+#include <core/monitor/monitor.h>
+#include <core/video_format.h>
+
+#include <boost/optional.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace caspar { namespace ffmpeg {
+
+// Decoded frames of a clip around a playhead, for playback at other speeds than 1 and in reverse. The clip is
+// decoded in chunks of whole GOPs, each on one of a few decoders of their own, ahead of the playhead in the
+// direction of playback. Frames furthest from the playhead are dropped to stay within the memory budget.
+class AVFrameCache
+{
+  public:
+    AVFrameCache(std::shared_ptr<core::frame_factory> frame_factory,
+                 core::video_format_desc              format_desc,
+                 std::string                          name,
+                 std::string                          path,
+                 boost::optional<std::string>         vfilter,
+                 boost::optional<std::string>         afilter);
+    ~AVFrameCache();
+
+    // The frame at time (in channel frames, as AVProducer::time()), or an empty frame if it has not been decoded
+    // yet. Decoding is scheduled around time, in the direction of speed.
+    core::draw_frame get(int64_t time, double speed);
+
+    caspar::core::monitor::state state() const;
+
+  private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+}} // namespace caspar::ffmpeg
@@ -1,12 +1,23 @@
 #include "av_input.h"
 
+#include "av_io.h"
+
 #include "../util/av_assert.h"
 #include "../util/av_util.h"
 
+#include <common/env.h>
 #include <common/except.h>
 #include <common/os/thread.h>
 #include <common/scope_exit.h>
 
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <deque>
+#include <map>
+#include <vector>
+
 #ifdef _MSC_VER
 #pragma warning(push)
 #pragma warning(disable : 4244)
@@ -20,6 +31,160 @@ extern "C" {
 
 namespace caspar { namespace ffmpeg {
 
+namespace {
+
+// What avformat_find_stream_info() found in a file, so that opening it again, e.g. for LOADBG of the same clip or
+// when looping, does not need to read and decode the start of it.
+struct StreamInfo
+{
+    struct Stream
+    {
+        std::shared_ptr<AVCodecParameters> codecpar;
+        AVRational                         time_base;
+        AVRational                         r_frame_rate;
+        AVRational                         avg_frame_rate;
+        AVRational                         sample_aspect_ratio;
+        int64_t                            start_time;
+        int64_t                            duration;
+        int64_t                            nb_frames;
+    };
+
+    std::string         format;
+    int64_t             start_time;
+    int64_t             duration;
+    int64_t             bit_rate;
+    std::vector<Stream> streams;
+
+    explicit StreamInfo(AVFormatContext* ic)
+        : format(ic->iformat->name)
+        , start_time(ic->start_time)
+        , duration(ic->duration)
+        , bit_rate(ic->bit_rate)
+    {
+        for (auto n = 0U; n < ic->nb_streams; ++n) {
+            const auto st = ic->streams[n];
+
+            auto codecpar = std::shared_ptr<AVCodecParameters>(
+                avcodec_parameters_alloc(), [](AVCodecParameters* ptr) { avcodec_parameters_free(&ptr); });
+            if (!codecpar) {
+                FF_RET(AVERROR(ENOMEM), "avcodec_parameters_alloc");
+            }
+            FF(avcodec_parameters_copy(codecpar.get(), st->codecpar));
+
+            streams.push_back(Stream{codecpar,
+                                     st->time_base,
+                                     st->r_frame_rate,
+                                     st->avg_frame_rate,
+                                     st->sample_aspect_ratio,
+                                     st->start_time,
+                                     st->duration,
+                                     st->nb_frames});
+        }
+    }
+
+    // Fills in what probing would have found, as long as the demuxer found the same streams.
+    bool apply(AVFormatContext* ic) const
+    {
+        if (ic->nb_streams != streams.size()) {
+            return false;
+        }
+
+        for (auto n = 0U; n < ic->nb_streams; ++n) {
+            const auto  st = ic->streams[n];
+            const auto& s  = streams[n];
+            if (st->codecpar->codec_type != s.codecpar->codec_type || st->codecpar->codec_id != s.codecpar->codec_id ||
+                av_cmp_q(st->time_base, s.time_base) != 0) {
+                return false;
+            }
+        }
+
+        for (auto n = 0U; n < ic->nb_streams; ++n) {
+            const auto  st = ic->streams[n];
+            const auto& s  = streams[n];
+            FF(avcodec_parameters_copy(st->codecpar, s.codecpar.get()));
+            st->r_frame_rate        = s.r_frame_rate;
+            st->avg_frame_rate      = s.avg_frame_rate;
+            st->sample_aspect_ratio = s.sample_aspect_ratio;
+            st->start_time          = s.start_time;
+            st->duration            = s.duration;
+            st->nb_frames           = s.nb_frames;
+        }
+
+        ic->start_time = start_time;
+        ic->duration   = duration;
+        ic->bit_rate   = bit_rate;
+
+        return true;
+    }
+};
+
+class StreamInfoCache
+{
+    std::mutex                                               mutex_;
+    std::map<std::string, std::shared_ptr<const StreamInfo>> entries_;
+    std::deque<std::string>                                  order_;
+    const std::size_t                                        capacity_;
+
+  public:
+    StreamInfoCache()
+        : capacity_(env::properties().get(L"ffmpeg.producer.probe-cache-size", 256))
+    {
+    }
+
+    static StreamInfoCache& instance()
+    {
+        static StreamInfoCache instance;
+        return instance;
+    }
+
+    // Local files are identified by path, size and modification time. Anything else is not cached.
+    static std::string key(const std::string& filename)
+    {
+        boost::system::error_code ec;
+
+        const auto path = boost::filesystem::path(filename);
+        const auto size = boost::filesystem::file_size(path, ec);
+        if (ec) {
+            return "";
+        }
+        const auto mtime = boost::filesystem::last_write_time(path, ec);
+        if (ec) {
+            return "";
+        }
+
+        return filename + "|" + boost::lexical_cast<std::string>(size) + "|" + boost::lexical_cast<std::string>(mtime);
+    }
+
+    std::shared_ptr<const StreamInfo> find(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto                        it = entries_.find(key);
+        return it != entries_.end() ? it->second : nullptr;
+    }
+
+    void insert(const std::string& key, std::shared_ptr<const StreamInfo> info)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!entries_.count(key)) {
+            order_.push_back(key);
+        }
+        entries_[key] = std::move(info);
+
+        while (order_.size() > capacity_) {
+            entries_.erase(order_.front());
+            order_.pop_front();
+        }
+    }
+
+    void erase(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.erase(key);
+    }
+};
+
+} // namespace
+
 Input::Input(const std::string& filename, std::shared_ptr<diagnostics::graph> graph)
     : graph_(graph)
     , filename_(filename)
@@ -46,7 +211,6 @@ Input::Input(const std::string& filename, std::shared_ptr<diagnostics::graph> gr
 
                 auto packet = alloc_packet();
 
-                // TODO (perf) Non blocking av_read_frame when possible.
                 auto ret = av_read_frame(ic_.get(), packet.get());
 
                 {
@@ -119,9 +283,58 @@ void Input::reset()
     // TODO (fix) timeout?
     FF(av_dict_set(&options, "rw_timeout", "60000000", 0)); // 60 second IO timeout
 
+    auto& cache = StreamInfoCache::instance();
+
+    const auto key  = env::properties().get(L"ffmpeg.producer.probe-cache", true) ? cache.key(filename_) : "";
+    const auto info = key.empty() ? nullptr : cache.find(key);
+
+    // The format is known and the streams are filled in from the cache, only the header is read.
+    AVInputFormat* format = nullptr;
+    if (info) {
+        format = av_find_input_format(info->format.c_str());
+        FF(av_dict_set(&options, "probesize", "65536", 0));
+    }
+
+    // Files are read ahead on a thread of their own, which is kept when the input is reset, e.g. on loop.
+    const auto local = filename_.find("://") == std::string::npos;
+
+    auto io = std::shared_ptr<FileIO>();
+    if (local && env::properties().get(L"ffmpeg.producer.read-ahead", 32) > 0) {
+        {
+            std::lock_guard<std::mutex> lock(io_mutex_);
+            io = io_;
+        }
+        if (io) {
+            ic_.reset();
+            FF(avio_seek(io->context(), 0, SEEK_SET));
+        } else {
+            try {
+                io = std::make_shared<FileIO>(filename_, graph_, [this] { return abort_request_.load(); });
+            } catch (...) {
+                CASPAR_LOG_CURRENT_EXCEPTION();
+            }
+        }
+    }
+
     AVFormatContext* ic = nullptr;
-    FF(avformat_open_input(&ic, filename_.c_str(), nullptr, &options));
-    ic_ = std::shared_ptr<AVFormatContext>(ic, [](AVFormatContext* ctx) { avformat_close_input(&ctx); });
+    if (io) {
+        FF(av_dict_set(&options, "rw_timeout", nullptr, 0)); // Protocol option, no protocol is used.
+
+        ic = avformat_alloc_context();
+        if (!ic) {
+            FF_RET(AVERROR(ENOMEM), "avformat_alloc_context");
+        }
+        ic->pb = io->context();
+        ic->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+    FF(avformat_open_input(&ic, filename_.c_str(), format, &options));
+    // The context must not outlive the reader it reads from.
+    ic_ = std::shared_ptr<AVFormatContext>(ic, [io](AVFormatContext* ctx) { avformat_close_input(&ctx); });
+
+    {
+        std::lock_guard<std::mutex> lock(io_mutex_);
+        io_ = io;
+    }
 
     for (auto& p : to_map(&options)) {
         CASPAR_LOG(warning) << "av_input[" + filename_ + "]"
@@ -131,7 +344,34 @@ void Input::reset()
     ic_->interrupt_callback.callback = Input::interrupt_cb;
     ic_->interrupt_callback.opaque   = this;
 
+    cached_ = info && info->apply(ic_.get());
+    if (cached_) {
+        return;
+    }
+
+    if (info) {
+        CASPAR_LOG(debug) << "av_input[" + filename_ + "]"
+                          << " Streams differ from the cached ones, probing.";
+        cache.erase(key);
+
+        // Back to the defaults for probing.
+        ic_->probesize            = 5000000;
+        ic_->max_analyze_duration = 0;
+    }
+
     FF(avformat_find_stream_info(ic_.get(), nullptr));
+
+    if (!key.empty()) {
+        cache.insert(key, std::make_shared<StreamInfo>(ic_.get()));
+    }
+}
+
+bool Input::cached() const { return cached_; }
+
+core::monitor::state Input::state() const
+{
+    std::lock_guard<std::mutex> lock(io_mutex_);
+    return io_ ? io_->state() : core::monitor::state();
 }
 
 bool Input::eof() const { return eof_; }
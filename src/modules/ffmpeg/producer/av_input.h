@@ -2,6 +2,8 @@
 
 #include <common/diagnostics/graph.h>
 
+#include <core/monitor/monitor.h>
+
 #include <boost/optional.hpp>
 
 #include <atomic>
@@ -19,6 +21,8 @@ struct AVFormatContext;
 
 namespace caspar { namespace ffmpeg {
 
+class FileIO;
+
 class Input
 {
   public:
@@ -35,6 +39,12 @@ class Input
 
     void reset();
     bool eof() const;
+
+    // Whether the last reset() took the stream info from the cache instead of probing.
+    bool cached() const;
+
+    // Read statistics, for local files.
+    caspar::core::monitor::state state() const;
     void abort();
 
     void seek(int64_t ts, bool flush = true);
@@ -46,12 +56,16 @@ class Input
     mutable std::mutex               ic_mutex_;
     std::shared_ptr<AVFormatContext> ic_;
 
+    mutable std::mutex      io_mutex_;
+    std::shared_ptr<FileIO> io_;
+
     mutable std::mutex                    mutex_;
     std::condition_variable               cond_;
     std::size_t                           output_capacity_ = 256;
     std::queue<std::shared_ptr<AVPacket>> output_;
 
     std::atomic<bool> eof_{false};
+    std::atomic<bool> cached_{false};
 
     std::atomic<bool> abort_request_{false};
     std::thread       thread_;
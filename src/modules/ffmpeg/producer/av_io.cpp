@@ -0,0 +1,432 @@
+#include "av_io.h"
+
+#include "../util/av_assert.h"
+
+#include <common/env.h>
+#include <common/except.h>
+#include <common/log.h>
+#include <common/os/thread.h>
+#include <common/utf.h>
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable : 4244)
+#endif
+extern "C" {
+#include <libavformat/avio.h>
+#include <libavutil/mem.h>
+}
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+namespace caspar { namespace ffmpeg {
+
+namespace {
+
+#ifdef _MSC_VER
+int open_file(const std::string& filename) { return _wopen(u16(filename).c_str(), _O_RDONLY | _O_BINARY); }
+
+int64_t file_size(int fd) { return _filelengthi64(fd); }
+
+// Only the I/O thread reads, so seeking and reading need not be atomic.
+int64_t read_at(int fd, uint8_t* data, int64_t size, int64_t offset)
+{
+    if (_lseeki64(fd, offset, SEEK_SET) < 0) {
+        return -1;
+    }
+    return _read(fd, data, static_cast<unsigned int>(size));
+}
+
+void close_file(int fd) { _close(fd); }
+#else
+int open_file(const std::string& filename) { return open(filename.c_str(), O_RDONLY); }
+
+int64_t file_size(int fd)
+{
+    struct stat st;
+    return fstat(fd, &st) == 0 ? static_cast<int64_t>(st.st_size) : -1;
+}
+
+int64_t read_at(int fd, uint8_t* data, int64_t size, int64_t offset)
+{
+    return pread(fd, data, static_cast<size_t>(size), static_cast<off_t>(offset));
+}
+
+void close_file(int fd) { close(fd); }
+#endif
+
+} // namespace
+
+struct FileIO::Impl
+{
+    typedef std::chrono::steady_clock clock_t;
+
+    const std::string                   filename_;
+    std::shared_ptr<diagnostics::graph> graph_;
+    const std::function<bool()>         interrupted_;
+    const int64_t                       block_size_;
+    const int64_t                       blocks_ahead_;
+    const int64_t                       blocks_behind_;
+
+    int      fd_   = -1;
+    int64_t  size_ = 0;
+    uint8_t* map_  = nullptr;
+
+    AVIOContext* context_ = nullptr;
+
+    mutable std::mutex                                      mutex_;
+    std::condition_variable                                 cond_;
+    std::map<int64_t, std::shared_ptr<std::vector<uint8_t>>> blocks_;
+    int64_t                                                 position_ = 0;
+    int                                                     error_    = 0;
+    bool                                                    abort_    = false;
+
+    int64_t bytes_read_    = 0; // From the file.
+    int64_t bytes_served_  = 0; // To the demuxer.
+    double  read_time_     = 0.0;
+    double  stall_time_    = 0.0;
+    int64_t stalls_        = 0;
+    int64_t seeks_         = 0;
+    int64_t seeks_cached_  = 0;
+
+    std::thread thread_;
+
+    Impl(const std::string& filename, std::shared_ptr<diagnostics::graph> graph, std::function<bool()> interrupted)
+        : filename_(filename)
+        , graph_(std::move(graph))
+        , interrupted_(std::move(interrupted))
+        , block_size_(std::max(64, env::properties().get(L"ffmpeg.producer.read-ahead-block", 1024)) * 1024LL)
+        , blocks_ahead_(std::max<int64_t>(
+              2, env::properties().get(L"ffmpeg.producer.read-ahead", 32) * 1024LL * 1024LL / block_size_))
+        , blocks_behind_(std::max<int64_t>(1, blocks_ahead_ / 4))
+    {
+        fd_ = open_file(filename_);
+        if (fd_ < 0) {
+            CASPAR_THROW_EXCEPTION(file_not_found() << msg_info("Could not open " + filename_));
+        }
+        size_ = file_size(fd_);
+        if (size_ < 0) {
+            close_file(fd_);
+            CASPAR_THROW_EXCEPTION(io_error() << msg_info("Could not stat " + filename_));
+        }
+
+#ifndef _MSC_VER
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+        if (env::properties().get(L"ffmpeg.producer.read-ahead-mmap", false) && size_ > 0) {
+            auto map = mmap(nullptr, static_cast<size_t>(size_), PROT_READ, MAP_PRIVATE, fd_, 0);
+            if (map != MAP_FAILED) {
+                map_ = static_cast<uint8_t*>(map);
+                posix_madvise(map_, static_cast<size_t>(size_), POSIX_MADV_SEQUENTIAL);
+            } else {
+                CASPAR_LOG(warning) << "av_io[" + filename_ + "] mmap failed, reading instead.";
+            }
+        }
+#endif
+
+        const int buffer_size = 64 * 1024;
+        auto      buffer      = static_cast<unsigned char*>(av_malloc(buffer_size));
+        if (!buffer) {
+            close();
+            FF_RET(AVERROR(ENOMEM), "av_malloc");
+        }
+        context_ = avio_alloc_context(buffer, buffer_size, 0, this, &Impl::read_packet, nullptr, &Impl::seek);
+        if (!context_) {
+            av_free(buffer);
+            close();
+            FF_RET(AVERROR(ENOMEM), "avio_alloc_context");
+        }
+
+        if (!map_) {
+            thread_ = std::thread([this] {
+                set_thread_name(L"[ffmpeg::av_producer::FileIO]");
+                run();
+            });
+        }
+    }
+
+    ~Impl()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            abort_ = true;
+        }
+        cond_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+
+        if (context_) {
+            av_freep(&context_->buffer);
+            av_freep(&context_);
+        }
+        close();
+    }
+
+    void close()
+    {
+#ifndef _MSC_VER
+        if (map_) {
+            munmap(map_, static_cast<size_t>(size_));
+            map_ = nullptr;
+        }
+#endif
+        if (fd_ >= 0) {
+            close_file(fd_);
+            fd_ = -1;
+        }
+    }
+
+    int64_t nb_blocks() const { return (size_ + block_size_ - 1) / block_size_; }
+
+    // Called with mutex_ held. The next block the demuxer will want which is not in memory, or -1.
+    int64_t wanted() const
+    {
+        const auto first = position_ / block_size_;
+        const auto last  = std::min(first + blocks_ahead_, nb_blocks());
+        for (auto n = first; n < last; ++n) {
+            if (!blocks_.count(n)) {
+                return n;
+            }
+        }
+        return -1;
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        while (!abort_) {
+            const auto block = wanted();
+            if (block < 0 || error_ != 0) {
+                cond_.wait(lock);
+                continue;
+            }
+
+            const auto offset = block * block_size_;
+            const auto length = std::min(block_size_, size_ - offset);
+
+            lock.unlock();
+
+            auto data = std::make_shared<std::vector<uint8_t>>(static_cast<std::size_t>(length));
+
+            const auto start = clock_t::now();
+            int64_t    count = 0;
+            while (count < static_cast<int64_t>(data->size())) {
+                const auto ret = read_at(fd_, data->data() + count, data->size() - count, offset + count);
+                if (ret <= 0) {
+                    break;
+                }
+                count += ret;
+            }
+            const auto elapsed = std::chrono::duration<double>(clock_t::now() - start).count();
+
+#ifndef _MSC_VER
+            // Lets the kernel start on what comes after the window.
+            posix_fadvise(fd_, offset + blocks_ahead_ * block_size_, block_size_, POSIX_FADV_WILLNEED);
+#endif
+
+            lock.lock();
+
+            read_time_ += elapsed;
+            if (count < static_cast<int64_t>(data->size())) {
+                error_ = AVERROR(EIO);
+                CASPAR_LOG(error) << "av_io[" + filename_ + "] Read failed at " << offset + count;
+            } else {
+                bytes_read_ += count;
+                // A block read before the file grew is short, it is read again.
+                if (length == std::min(block_size_, size_ - offset)) {
+                    blocks_[block] = std::move(data);
+                }
+            }
+
+            // Drops what is too far behind or ahead of the read position.
+            const auto first = position_ / block_size_;
+            for (auto it = blocks_.begin(); it != blocks_.end();) {
+                const auto keep = it->first >= first - blocks_behind_ && it->first < first + blocks_ahead_;
+                it              = keep ? std::next(it) : blocks_.erase(it);
+            }
+
+            cond_.notify_all();
+        }
+    }
+
+    static int read_packet(void* opaque, uint8_t* buf, int buf_size)
+    {
+        return static_cast<Impl*>(opaque)->read(buf, buf_size);
+    }
+
+    int read(uint8_t* buf, int buf_size)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (position_ >= size_ && !grow()) {
+            return AVERROR_EOF;
+        }
+
+        const auto size = static_cast<int>(std::min<int64_t>(buf_size, size_ - position_));
+
+        if (map_) {
+            std::memcpy(buf, map_ + position_, size);
+            position_ += size;
+            bytes_served_ += size;
+            return size;
+        }
+
+        const auto block = position_ / block_size_;
+
+        auto it = blocks_.find(block);
+        if (it == blocks_.end()) {
+            const auto start = clock_t::now();
+            stalls_ += 1;
+            if (graph_) {
+                graph_->set_tag(diagnostics::tag_severity::WARNING, "io-stall");
+            }
+
+            while ((it = blocks_.find(block)) == blocks_.end()) {
+                if (error_ != 0) {
+                    return error_;
+                }
+                if (abort_ || interrupted_()) {
+                    return AVERROR_EXIT;
+                }
+                cond_.wait_for(lock, std::chrono::milliseconds(10));
+            }
+
+            stall_time_ += std::chrono::duration<double>(clock_t::now() - start).count();
+        }
+
+        const auto offset = position_ - block * block_size_;
+        const auto count  = static_cast<int>(std::min<int64_t>(size, it->second->size() - offset));
+        std::memcpy(buf, it->second->data() + offset, count);
+
+        position_ += count;
+        bytes_served_ += count;
+
+        if (position_ / block_size_ != block) {
+            cond_.notify_all();
+        }
+
+        return count;
+    }
+
+    // Called with mutex_ held. Picks up what was written to the file since it was opened, as ffmpeg's file
+    // protocol does. A memory mapped file keeps the size it was mapped with.
+    bool grow()
+    {
+        if (map_) {
+            return false;
+        }
+
+        const auto size = file_size(fd_);
+        if (size <= size_) {
+            return false;
+        }
+
+        // The last block was cut short by the old end of the file.
+        if (size_ % block_size_ != 0) {
+            blocks_.erase(size_ / block_size_);
+        }
+        size_ = size;
+        cond_.notify_all();
+
+        return true;
+    }
+
+    static int64_t seek(void* opaque, int64_t offset, int whence)
+    {
+        return static_cast<Impl*>(opaque)->seek(offset, whence);
+    }
+
+    int64_t seek(int64_t offset, int whence)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        switch (whence & ~AVSEEK_FORCE) {
+            case AVSEEK_SIZE:
+                return size_;
+            case SEEK_SET:
+                break;
+            case SEEK_CUR:
+                offset += position_;
+                break;
+            case SEEK_END:
+                offset += size_;
+                break;
+            default:
+                return AVERROR(EINVAL);
+        }
+
+        if (offset < 0) {
+            return AVERROR(EINVAL);
+        }
+
+        seeks_ += 1;
+        if (map_ || blocks_.count(offset / block_size_)) {
+            seeks_cached_ += 1;
+        }
+
+        position_ = offset;
+        error_    = 0;
+        cond_.notify_all();
+
+        return position_;
+    }
+
+    core::monitor::state state() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        core::monitor::state state;
+        state["mode"]         = map_ ? std::string("mmap") : std::string("read-ahead");
+        state["buffered"]     = static_cast<int64_t>(blocks_.size()) * block_size_;
+        state["read"]         = bytes_read_;
+        state["served"]       = bytes_served_;
+        state["throughput"]   = read_time_ > 0.0 ? bytes_read_ / read_time_ : 0.0;
+        state["stalls"]       = stalls_;
+        state["stall-time"]   = stall_time_;
+        state["seeks"]        = seeks_;
+        state["seeks-cached"] = seeks_cached_;
+        return state;
+    }
+};
+
+FileIO::FileIO(const std::string&                  filename,
+               std::shared_ptr<diagnostics::graph> graph,
+               std::function<bool()>               interrupted)
+    : impl_(new Impl(filename, std::move(graph), std::move(interrupted)))
+{
+}
+
+FileIO::~FileIO() {}
+
+AVIOContext* FileIO::context() { return impl_->context_; }
+
+core::monitor::state FileIO::state() const { return impl_->state(); }
+
+}} // namespace caspar::ffmpeg
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <common/diagnostics/graph.h>
+
+#include <core/monitor/monitor.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+
+struct AVIOContext;
+
+namespace caspar { namespace ffmpeg {
+
+// Reads a local or network mounted file for the demuxer. A thread of its own keeps the blocks ahead of the read
+// position in memory, so that the demuxer rarely waits on the disk, and keeps a few behind it for short seeks back.
+// Optionally the file is memory mapped instead. Reading past the end picks up what has been written to the file
+// since, unless it is memory mapped.
+class FileIO
+{
+  public:
+    // Throws if the file cannot be opened. interrupted is polled while waiting for data.
+    FileIO(const std::string& filename, std::shared_ptr<diagnostics::graph> graph, std::function<bool()> interrupted);
+    ~FileIO();
+
+    FileIO(const FileIO&) = delete;
+    FileIO& operator=(const FileIO&) = delete;
+
+    AVIOContext* context();
+
+    caspar::core::monitor::state state() const;
+
+  private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+}} // namespace caspar::ffmpeg
@@ -52,6 +52,7 @@ extern "C" {
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <deque>
 #include <exception>
 #include <iomanip>
@@ -132,6 +133,18 @@ struct Decoder
         FF(avcodec_open2(ctx.get(), codec, nullptr));
     }
 
+    // Drops everything in flight so that the decoder can be fed again after a seek.
+    void flush()
+    {
+        if (ctx) {
+            avcodec_flush_buffers(ctx.get());
+        }
+        input    = std::queue<std::shared_ptr<AVPacket>>();
+        frame    = nullptr;
+        next_pts = AV_NOPTS_VALUE;
+        eof      = false;
+    }
+
     bool operator()()
     {
         if (frame || eof || !st) {
@@ -434,7 +447,7 @@ struct Filter
             const AVSampleFormat sample_fmts[] = {AV_SAMPLE_FMT_S32, AV_SAMPLE_FMT_NONE};
             FF(av_opt_set_int_list(sink, "sample_fmts", sample_fmts, -1, AV_OPT_SEARCH_CHILDREN));
 
-            // TODO Always output 8 channels and remove hack in make_frame.
+            // The source channel layout is kept, make_frame routes it into the channel layout.
 
             const int sample_rates[] = {format_desc.audio_sample_rate, -1};
             FF(av_opt_set_int_list(sink, "sample_rates", sample_rates, -1, AV_OPT_SEARCH_CHILDREN));
@@ -496,6 +509,17 @@ struct Filter
     }
 };
 
+// Filter graphs configured for a start time. libavfilter cannot rewind a graph, fps, bwdif and aresample keep state
+// and a source stays closed after EOF, so every seek needs new graphs. The ones for the loop point are built ahead.
+struct Graphs
+{
+    int64_t                 start_time = AV_NOPTS_VALUE;
+    core::video_format_desc format_desc;
+    std::map<int, Decoder>  decoders; // Streams the graphs read from which had no decoder yet.
+    Filter                  video;
+    Filter                  audio;
+};
+
 struct AVProducer::Impl
 {
     caspar::core::monitor::state state_;
@@ -504,8 +528,8 @@ struct AVProducer::Impl
     spl::shared_ptr<diagnostics::graph> graph_;
 
     const std::shared_ptr<core::frame_factory> frame_factory_;
-    const core::video_format_desc              format_desc_;
-    const AVRational                           format_tb_;
+    core::video_format_desc                    format_desc_; // Only written by the decoding thread.
+    AVRational                                 format_tb_;
     const std::string                          name_;
     const std::string                          path_;
 
@@ -516,6 +540,12 @@ struct AVProducer::Impl
 
     std::map<int, std::vector<AVFilterContext*>> sources_;
 
+    std::unique_ptr<Graphs> spare_;
+    int64_t                 graph_builds_   = 0;
+    int64_t                 graph_reuses_   = 0;
+    double                  graph_time_     = 0.0;
+    double                  graph_time_max_ = 0.0;
+
     std::atomic<int64_t> start_{AV_NOPTS_VALUE};
     std::atomic<int64_t> duration_{AV_NOPTS_VALUE};
     std::atomic<int64_t> input_duration_{AV_NOPTS_VALUE};
@@ -540,6 +570,32 @@ struct AVProducer::Impl
 
     int latency_ = 0;
 
+    // From construction until the first frame is buffered.
+    caspar::timer load_timer_;
+    bool          loaded_ = false;
+
+    // Frames shown last and frames a seek took out of the buffer, up to the last one decoded. Seeks into them are
+    // served from memory.
+    std::deque<Frame>   history_;
+    const std::size_t   history_capacity_;
+    const int64_t       seek_horizon_;
+    std::deque<int64_t> keyframes_; // Of the video stream as read by the demuxer.
+    int64_t             skip_until_ = AV_NOPTS_VALUE;
+
+    typedef std::chrono::steady_clock seek_clock_t;
+
+    seek_clock_t::time_point seek_requested_;
+    std::string              seek_method_;
+    bool                     seek_measure_ = false;
+    int64_t                  seeks_retained_ = 0;
+    int64_t                  seeks_decoded_  = 0;
+    int64_t                  seeks_demuxed_  = 0;
+    double                   seek_latency_     = 0.0;
+    double                   seek_latency_max_ = 0.0;
+
+    mutable boost::mutex                     format_mutex_;
+    boost::optional<core::video_format_desc> format_request_;
+
     boost::thread     thread_;
     std::atomic<bool> abort_request_{false};
 
@@ -561,11 +617,16 @@ struct AVProducer::Impl
         , start_(start ? av_rescale_q(*start, format_tb_, TIME_BASE_Q) : AV_NOPTS_VALUE)
         , duration_(duration ? av_rescale_q(*duration, format_tb_, TIME_BASE_Q) : AV_NOPTS_VALUE)
         , loop_(loop)
+        , history_capacity_(std::max(0, env::properties().get(L"ffmpeg.producer.seek-history", 8)))
+        , seek_horizon_(av_rescale_q(std::max(0, env::properties().get(L"ffmpeg.producer.seek-horizon", 1000)),
+                                     {1, 1000},
+                                     TIME_BASE_Q))
         , vfilter_(vfilter)
         , afilter_(afilter)
     {
         diagnostics::register_graph(graph_);
         graph_->set_color("underflow", diagnostics::color(0.6f, 0.3f, 0.9f));
+        graph_->set_color("offline-timeout", diagnostics::color(1.0f, 0.3f, 0.3f));
         graph_->set_color("frame-time", diagnostics::color(0.0f, 1.0f, 0.0f));
         graph_->set_color("buffer", diagnostics::color(1.0f, 1.0f, 0.0f));
 
@@ -581,6 +642,11 @@ struct AVProducer::Impl
                 // Do nothing...
             } catch (...) {
                 CASPAR_LOG_CURRENT_EXCEPTION();
+
+                // Nothing more will be decoded, let next_frame() report the end rather than underflow.
+                boost::lock_guard<boost::mutex> lock(buffer_mutex_);
+                buffer_eof_ = true;
+                buffer_cond_.notify_all();
             }
         });
     }
@@ -597,7 +663,14 @@ struct AVProducer::Impl
     {
         std::vector<int> audio_cadence = format_desc_.audio_cadence;
 
-        input_.reset();
+        {
+            caspar::timer open_timer;
+            input_.reset();
+
+            boost::lock_guard<boost::mutex> lock(state_mutex_);
+            state_["file/open-time"] = open_timer.elapsed();
+            state_["file/cached"]    = input_.cached();
+        }
 
         for (auto n = 0UL; n < input_->nb_streams; ++n) {
             auto st        = input_->streams[n];
@@ -637,8 +710,14 @@ struct AVProducer::Impl
                 const auto seek = seek_.exchange(AV_NOPTS_VALUE);
 
                 if (seek != AV_NOPTS_VALUE) {
-                    seek_internal(seek);
-                    frame = Frame{};
+                    if (update_format(audio_cadence) || !seek_planned(seek)) {
+                        seek_internal(seek);
+                        frame = Frame{};
+
+                        seeks_demuxed_ += 1;
+                        seek_method_  = "demuxed";
+                        seek_measure_ = true;
+                    }
                     continue;
                 }
             }
@@ -653,14 +732,22 @@ struct AVProducer::Impl
                 auto end  = duration != AV_NOPTS_VALUE ? start + duration : INT64_MAX;
                 auto time = frame.pts != AV_NOPTS_VALUE ? frame.pts + frame.duration : 0;
 
-                buffer_eof_ = (video_filter_.eof && audio_filter_.eof) ||
-                              av_rescale_q(time, TIME_BASE_Q, format_tb_) >= av_rescale_q(end, TIME_BASE_Q, format_tb_);
+                // A pending seek is handled first, it would make this eof stale.
+                buffer_eof_ = seek_ == AV_NOPTS_VALUE &&
+                              ((video_filter_.eof && audio_filter_.eof) ||
+                               av_rescale_q(time, TIME_BASE_Q, format_tb_) >=
+                                   av_rescale_q(end, TIME_BASE_Q, format_tb_));
 
                 if (buffer_eof_) {
                     if (loop_ && frame_count_ > 2) {
                         frame = Frame{};
                         seek_internal(start);
                     } else {
+                        {
+                            // Wakes up a next_frame() waiting for a frame which will not come.
+                            boost::lock_guard<boost::mutex> buffer_lock(buffer_mutex_);
+                            buffer_cond_.notify_all();
+                        }
                         boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
                     }
                     // TODO (fix) Limit live polling due to bugs.
@@ -721,22 +808,62 @@ struct AVProducer::Impl
                 frame.duration   = av_rescale_q(frame.audio->nb_samples, {1, sr}, TIME_BASE_Q);
             }
 
-            frame.frame = core::draw_frame(make_frame(this, *frame_factory_, frame.video, frame.audio));
+            if (skip_until_ != AV_NOPTS_VALUE) {
+                if (frame.pts + frame.duration <= skip_until_) {
+                    continue;
+                }
+                skip_until_ = AV_NOPTS_VALUE;
+            }
+
+            frame.frame = core::draw_frame(make_frame(
+                this, *frame_factory_, frame.video, frame.audio, format_desc_.audio_channels));
 
             graph_->set_value("frame-time", frame_timer.elapsed() * format_desc_.fps * 0.5);
             frame_timer.restart();
 
+            // Waiting for room in the buffer is the time to get the graphs for the next loop ready.
+            if (loop_ && !spare_) {
+                auto full = false;
+                {
+                    boost::lock_guard<boost::mutex> buffer_lock(buffer_mutex_);
+                    full = buffer_.size() >= buffer_capacity_;
+                }
+                if (full) {
+                    auto start = start_.load();
+                    spare_     = build(input_time(start != AV_NOPTS_VALUE ? start : 0));
+                }
+            }
+
             {
                 boost::unique_lock<boost::mutex> buffer_lock(buffer_mutex_);
                 buffer_cond_.wait(buffer_lock, [&] { return buffer_.size() < buffer_capacity_ || abort_request_; });
                 if (seek_ == AV_NOPTS_VALUE) {
                     buffer_.push_back(frame);
+                    buffer_cond_.notify_all();
+                } else {
+                    // seek() already moved the buffer to the history, this frame follows it.
+                    history_.push_back(retained(frame));
+                }
+                if (seek_measure_) {
+                    seek_measure_ = false;
+                    seek_measured();
                 }
             }
 
             frame_count_ += 1;
             graph_->set_value("buffer", static_cast<double>(buffer_.size()) / static_cast<double>(buffer_capacity_));
 
+            if (!loaded_) {
+                loaded_ = true;
+
+                const auto load_time = load_timer_.elapsed();
+                CASPAR_LOG(debug) << print() << " First frame after " << load_time * 1000.0 << " ms"
+                                  << (input_.cached() ? " (cached stream info)." : ".");
+
+                boost::lock_guard<boost::mutex> lock(state_mutex_);
+                state_["file/load-time"] = load_time;
+            }
+
             boost::range::rotate(audio_cadence, std::end(audio_cadence) - 1);
         }
     }
@@ -745,9 +872,11 @@ struct AVProducer::Impl
     {
         graph_->set_text(u16(print()));
         boost::lock_guard<boost::mutex> lock(state_mutex_);
-        state_["file/clip"] = {start().value_or(0) / format_desc_.fps, duration().value_or(0) / format_desc_.fps};
-        state_["file/time"] = {time() / format_desc_.fps, file_duration().value_or(0) / format_desc_.fps};
+        const auto fps      = av_q2d(av_inv_q(format_tb()));
+        state_["file/clip"] = {start().value_or(0) / fps, duration().value_or(0) / fps};
+        state_["file/time"] = {time() / fps, file_duration().value_or(0) / fps};
         state_["loop"]      = loop_;
+        state_["file/io"]   = input_.state();
     }
 
     core::draw_frame prev_frame()
@@ -769,13 +898,25 @@ struct AVProducer::Impl
         return core::draw_frame::still(frame_);
     }
 
-    core::draw_frame next_frame()
+    core::draw_frame next_frame(bool offline)
     {
         CASPAR_SCOPE_EXIT { update_state(); };
 
-        boost::lock_guard<boost::mutex> lock(buffer_mutex_);
+        boost::unique_lock<boost::mutex> lock(buffer_mutex_);
 
-        if (buffer_.empty() || (frame_flush_ && buffer_.size() < 4)) {
+        // An offline channel waits for the decoder rather than repeat a frame. The wait is bounded so that a decoder
+        // which stopped without reaching the end cannot stall the channel.
+        if (offline && underflow() && !buffer_eof_) {
+            auto ready = buffer_cond_.wait_for(lock, boost::chrono::seconds(10), [&] {
+                return !underflow() || buffer_eof_ || abort_request_;
+            });
+            if (!ready) {
+                graph_->set_tag(diagnostics::tag_severity::WARNING, "offline-timeout");
+                CASPAR_LOG(warning) << print() << " Decoder did not deliver a frame within 10 s, repeating a frame.";
+            }
+        }
+
+        if (underflow()) {
             if (buffer_eof_) {
                 frame_eof_ = true;
                 return core::draw_frame::still(frame_);
@@ -796,6 +937,11 @@ struct AVProducer::Impl
         frame_flush_    = false;
         frame_eof_      = false;
 
+        history_.push_back(retained(buffer_[0]));
+        while (history_.size() > history_capacity_) {
+            history_.pop_front();
+        }
+
         buffer_.pop_front();
         buffer_cond_.notify_all();
 
@@ -804,14 +950,32 @@ struct AVProducer::Impl
         return frame_;
     }
 
+    bool ready() const
+    {
+        boost::lock_guard<boost::mutex> lock(buffer_mutex_);
+        return !underflow() || buffer_eof_;
+    }
+
+    bool eof() const
+    {
+        boost::lock_guard<boost::mutex> lock(buffer_mutex_);
+        return buffer_.empty() && buffer_eof_;
+    }
+
     void seek(int64_t time)
     {
         CASPAR_SCOPE_EXIT { update_state(); };
 
-        seek_ = av_rescale_q(time, format_tb_, TIME_BASE_Q);
+        const auto tb = format_tb();
 
         {
             boost::lock_guard<boost::mutex> lock(buffer_mutex_);
+            seek_           = av_rescale_q(time, tb, TIME_BASE_Q);
+            seek_requested_ = seek_clock_t::now();
+            buffer_eof_     = false;
+            for (auto& frame : buffer_) {
+                history_.push_back(retained(frame));
+            }
             buffer_.clear();
             buffer_cond_.notify_all();
             graph_->set_value("buffer", static_cast<double>(buffer_.size()) / static_cast<double>(buffer_capacity_));
@@ -831,7 +995,7 @@ struct AVProducer::Impl
             frame_time += frame_duration_;
         }
 
-        return av_rescale_q(frame_time, TIME_BASE_Q, format_tb_);
+        return av_rescale_q(frame_time, TIME_BASE_Q, format_tb());
     }
 
     void loop(bool loop)
@@ -847,26 +1011,26 @@ struct AVProducer::Impl
     {
         CASPAR_SCOPE_EXIT { update_state(); };
 
-        start_ = av_rescale_q(start, format_tb_, TIME_BASE_Q);
+        start_ = av_rescale_q(start, format_tb(), TIME_BASE_Q);
     }
 
     boost::optional<int64_t> start() const
     {
         auto start = start_.load();
-        return start != AV_NOPTS_VALUE ? av_rescale_q(start, TIME_BASE_Q, format_tb_) : boost::optional<int64_t>();
+        return start != AV_NOPTS_VALUE ? av_rescale_q(start, TIME_BASE_Q, format_tb()) : boost::optional<int64_t>();
     }
 
     void duration(int64_t duration)
     {
         CASPAR_SCOPE_EXIT { update_state(); };
 
-        duration_ = av_rescale_q(duration, format_tb_, TIME_BASE_Q);
+        duration_ = av_rescale_q(duration, format_tb(), TIME_BASE_Q);
     }
 
     boost::optional<int64_t> duration() const
     {
         const auto duration = duration_.load();
-        return duration != AV_NOPTS_VALUE ? boost::optional<int64_t>(av_rescale_q(duration, TIME_BASE_Q, format_tb_))
+        return duration != AV_NOPTS_VALUE ? boost::optional<int64_t>(av_rescale_q(duration, TIME_BASE_Q, format_tb()))
                                           : boost::none;
     }
 
@@ -874,11 +1038,125 @@ struct AVProducer::Impl
     {
         const auto input_duration = input_duration_.load();
         return input_duration != AV_NOPTS_VALUE
-                   ? boost::optional<int64_t>(av_rescale_q(input_duration, TIME_BASE_Q, format_tb_))
+                   ? boost::optional<int64_t>(av_rescale_q(input_duration, TIME_BASE_Q, format_tb()))
                    : boost::none;
     }
 
+    void format_desc(const core::video_format_desc& format_desc)
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(format_mutex_);
+            if (format_desc == (format_request_ ? *format_request_ : format_desc_)) {
+                return;
+            }
+            format_request_ = format_desc;
+        }
+
+        // The decoding thread picks up the new format with the seek, so the filters are rebuilt for it and decoding
+        // continues after the frame on screen.
+        seek(frame_time_ != AV_NOPTS_VALUE ? time() + 1 : start().value_or(0));
+    }
+
+    AVRational format_tb() const
+    {
+        boost::lock_guard<boost::mutex> lock(format_mutex_);
+        return format_tb_;
+    }
+
   private:
+    // Called with the buffer locked.
+    bool underflow() const { return buffer_.empty() || (frame_flush_ && buffer_.size() < 4); }
+
+    bool update_format(std::vector<int>& audio_cadence)
+    {
+        boost::lock_guard<boost::mutex> lock(format_mutex_);
+        if (!format_request_) {
+            return false;
+        }
+
+        format_desc_ = *format_request_;
+        format_tb_   = {format_desc_.duration, format_desc_.time_scale};
+        format_request_.reset();
+
+        audio_cadence = format_desc_.audio_cadence;
+        boost::range::rotate(audio_cadence, std::end(audio_cadence) - 1);
+
+        boost::lock_guard<boost::mutex> buffer_lock(buffer_mutex_);
+        buffer_capacity_ = static_cast<int>(format_desc_.fps) / 2;
+        return true;
+    }
+
+    static Frame retained(const Frame& frame)
+    {
+        Frame result;
+        result.frame      = frame.frame;
+        result.start_time = frame.start_time;
+        result.pts        = frame.pts;
+        result.duration   = frame.duration;
+        return result;
+    }
+
+    // Serves a seek without touching the demuxer where possible: from the history when the target is still in
+    // memory, or by decoding forward when no keyframe lies between the last decoded frame and the target and it is
+    // within the seek horizon, since a demuxer seek would then decode at least as much. Returns false when the
+    // demuxer has to seek.
+    bool seek_planned(int64_t time)
+    {
+        time = time != AV_NOPTS_VALUE ? time : 0;
+
+        boost::lock_guard<boost::mutex> lock(buffer_mutex_);
+
+        auto it = std::find_if(
+            history_.begin(), history_.end(), [&](const Frame& frame) { return frame.pts + frame.duration > time; });
+        if (it != history_.end() && it->pts <= time) {
+            buffer_.assign(it, history_.end());
+            history_.erase(it, history_.end());
+            frame_flush_ = true;
+            buffer_cond_.notify_all();
+
+            seeks_retained_ += 1;
+            seek_method_ = "retained";
+            seek_measured();
+            return true;
+        }
+
+        if (history_.empty() || (video_filter_.eof && audio_filter_.eof)) {
+            return false;
+        }
+
+        const auto position = history_.back().pts + history_.back().duration;
+        if (time < position || time - position > seek_horizon_ ||
+            std::any_of(keyframes_.begin(), keyframes_.end(), [&](int64_t pts) {
+                return pts > position && pts <= time;
+            })) {
+            return false;
+        }
+
+        history_.clear();
+        skip_until_  = time;
+        frame_flush_ = true;
+
+        seeks_decoded_ += 1;
+        seek_method_  = "decoded";
+        seek_measure_ = true;
+        return true;
+    }
+
+    // Called with the buffer locked once the first frame at the seek target is ready.
+    void seek_measured()
+    {
+        seek_latency_     = std::chrono::duration<double>(seek_clock_t::now() - seek_requested_).count();
+        seek_latency_max_ = std::max(seek_latency_max_, seek_latency_);
+
+        boost::lock_guard<boost::mutex> lock(state_mutex_);
+        state_["seek/method"]      = seek_method_;
+        state_["seek/retained"]    = seeks_retained_;
+        state_["seek/decoded"]     = seeks_decoded_;
+        state_["seek/demuxed"]     = seeks_demuxed_;
+        state_["seek/latency"]     = seek_latency_;
+        state_["seek/latency-max"] = seek_latency_max_;
+    }
+
     bool schedule()
     {
         auto result = false;
@@ -919,6 +1197,16 @@ struct AVProducer::Impl
 
                 result = true;
 
+                if ((packet->flags & AV_PKT_FLAG_KEY) && packet->pts != AV_NOPTS_VALUE &&
+                    it->second.ctx->codec_type == AVMEDIA_TYPE_VIDEO) {
+                    // Not the decoder's stream, which does not outlive a reset of the input.
+                    const auto tb = input_->streams[packet->stream_index]->time_base;
+                    keyframes_.push_back(av_rescale_q(packet->pts, tb, TIME_BASE_Q) - input_time(0));
+                    while (keyframes_.size() > 16) {
+                        keyframes_.pop_front();
+                    }
+                }
+
                 it->second.input.push(std::move(packet));
             }
 
@@ -967,26 +1255,94 @@ struct AVProducer::Impl
         return result;
     }
 
-    void seek_internal(int64_t time)
+    int64_t input_time(int64_t time) const
     {
         time = time != AV_NOPTS_VALUE ? time : 0;
-        time = time + (input_->start_time != AV_NOPTS_VALUE ? input_->start_time : 0);
+        return time + (input_->start_time != AV_NOPTS_VALUE ? input_->start_time : 0);
+    }
+
+    void seek_internal(int64_t time)
+    {
+        time = input_time(time);
 
-        // TODO (fix) Dont seek if time is close future.
         input_.seek(time);
         frame_flush_ = true;
         frame_count_ = 0;
         buffer_eof_  = false;
 
-        decoders_.clear();
+        // Seeking to the start reopens the input, which frees the streams the decoders point at.
+        const auto attach = [&](std::map<int, Decoder>& decoders) {
+            for (auto& p : decoders) {
+                if (p.first >= static_cast<int>(input_->nb_streams)) {
+                    CASPAR_THROW_EXCEPTION(ffmpeg_error_t() << boost::errinfo_errno(EINVAL)
+                                                            << msg_info_t("stream missing after reopening input"));
+                }
+                p.second.st = input_->streams[p.first];
+            }
+        };
+        attach(decoders_);
+        if (spare_) {
+            attach(spare_->decoders);
+        }
+
+        for (auto& p : decoders_) {
+            p.second.flush();
+        }
+
+        {
+            boost::lock_guard<boost::mutex> lock(buffer_mutex_);
+            history_.clear();
+            skip_until_ = AV_NOPTS_VALUE;
+        }
 
         reset(time);
     }
 
+    std::unique_ptr<Graphs> build(int64_t start_time)
+    {
+        caspar::timer timer;
+
+        auto graphs         = std::unique_ptr<Graphs>(new Graphs());
+        graphs->start_time  = start_time;
+        graphs->format_desc = format_desc_;
+        graphs->decoders    = decoders_;
+        graphs->video = Filter(vfilter_, input_, graphs->decoders, start_time, AVMEDIA_TYPE_VIDEO, format_desc_);
+        graphs->audio = Filter(afilter_, input_, graphs->decoders, start_time, AVMEDIA_TYPE_AUDIO, format_desc_);
+
+        for (auto& p : decoders_) {
+            graphs->decoders.erase(p.first);
+        }
+
+        graph_builds_ += 1;
+        graph_time_     = timer.elapsed();
+        graph_time_max_ = std::max(graph_time_max_, graph_time_);
+
+        boost::lock_guard<boost::mutex> lock(state_mutex_);
+        state_["filter/builds"]   = graph_builds_;
+        state_["filter/reuses"]   = graph_reuses_;
+        state_["filter/time"]     = graph_time_;
+        state_["filter/time-max"] = graph_time_max_;
+
+        return graphs;
+    }
+
     void reset(int64_t start_time)
     {
-        video_filter_ = Filter(vfilter_, input_, decoders_, start_time, AVMEDIA_TYPE_VIDEO, format_desc_);
-        audio_filter_ = Filter(afilter_, input_, decoders_, start_time, AVMEDIA_TYPE_AUDIO, format_desc_);
+        auto graphs = std::move(spare_);
+        if (graphs && graphs->start_time == start_time && graphs->format_desc == format_desc_) {
+            graph_reuses_ += 1;
+
+            boost::lock_guard<boost::mutex> lock(state_mutex_);
+            state_["filter/reuses"] = graph_reuses_;
+        } else {
+            graphs = build(start_time);
+        }
+
+        for (auto& p : graphs->decoders) {
+            decoders_.emplace(p.first, std::move(p.second));
+        }
+        video_filter_ = std::move(graphs->video);
+        audio_filter_ = std::move(graphs->audio);
 
         sources_.clear();
         for (auto& p : video_filter_.sources) {
@@ -1011,10 +1367,11 @@ struct AVProducer::Impl
 
     std::string print() const
     {
+        const auto         format_tb = this->format_tb();
         std::ostringstream str;
         str << std::fixed << std::setprecision(4) << "ffmpeg[" << name_ << "|"
-            << av_q2d({static_cast<int>(time()) * format_tb_.num, format_tb_.den}) << "/"
-            << av_q2d({static_cast<int>(duration().value_or(0LL)) * format_tb_.num, format_tb_.den}) << "]";
+            << av_q2d({static_cast<int>(time()) * format_tb.num, format_tb.den}) << "/"
+            << av_q2d({static_cast<int>(duration().value_or(0LL)) * format_tb.num, format_tb.den}) << "]";
         return str.str();
     }
 };
@@ -1040,16 +1397,26 @@ AVProducer::AVProducer(std::shared_ptr<core::frame_factory> frame_factory,
 {
 }
 
-core::draw_frame AVProducer::next_frame() { return impl_->next_frame(); }
+core::draw_frame AVProducer::next_frame(bool offline) { return impl_->next_frame(offline); }
 
 core::draw_frame AVProducer::prev_frame() { return impl_->prev_frame(); }
 
+bool AVProducer::ready() const { return impl_->ready(); }
+
+bool AVProducer::eof() const { return impl_->eof(); }
+
 AVProducer& AVProducer::seek(int64_t time)
 {
     impl_->seek(time);
     return *this;
 }
 
+AVProducer& AVProducer::format_desc(const core::video_format_desc& format_desc)
+{
+    impl_->format_desc(format_desc);
+    return *this;
+}
+
 AVProducer& AVProducer::loop(bool loop)
 {
     impl_->loop(loop);
@@ -1,3 +1,5 @@
+#pragma once
+
 #include <memory>
 
 #include <core/frame/draw_frame.h>
@@ -28,11 +30,22 @@ class AVProducer
                boost::optional<bool>                loop);
 
     core::draw_frame prev_frame();
-    core::draw_frame next_frame();
+
+    // Offline, waits for the decoder rather than return nothing on underflow.
+    core::draw_frame next_frame(bool offline = false);
+
+    // True once next_frame() has a frame to return, or the input has ended.
+    bool ready() const;
+
+    // True once every frame has been returned by next_frame().
+    bool eof() const;
 
     AVProducer& seek(int64_t time);
     int64_t     time() const;
 
+    // Rebuilds the filters for a new channel format and continues after the current frame.
+    AVProducer& format_desc(const core::video_format_desc& format_desc);
+
     AVProducer& loop(bool loop);
     bool        loop() const;
 
@@ -0,0 +1,267 @@
+#include "av_session.h"
+
+#include <common/env.h>
+#include <common/log.h>
+#include <common/utf.h>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <mutex>
+
+namespace caspar { namespace ffmpeg {
+
+struct Settings
+{
+    std::shared_ptr<core::frame_factory> frame_factory;
+    core::video_format_desc              format_desc;
+    std::string                          name;
+    std::string                          path;
+    boost::optional<std::string>         vfilter;
+    boost::optional<std::string>         afilter;
+    boost::optional<int64_t>             start;
+    boost::optional<int64_t>             duration;
+    boost::optional<bool>                loop;
+
+    std::string key() const
+    {
+        return path + "|" + vfilter.value_or("") + "|" + afilter.value_or("") + "|" +
+               (start ? boost::lexical_cast<std::string>(*start) : "") + "|" +
+               (duration ? boost::lexical_cast<std::string>(*duration) : "") + "|" +
+               boost::lexical_cast<std::string>(loop.value_or(false)) + "|" + u8(format_desc.name);
+    }
+
+    std::shared_ptr<AVProducer> open() const
+    {
+        return std::make_shared<AVProducer>(
+            frame_factory, format_desc, name, path, vfilter, afilter, start, duration, loop);
+    }
+};
+
+struct AVSession::Impl
+{
+    struct Frame
+    {
+        core::draw_frame frame;
+        int64_t          time;
+    };
+
+    const Settings                    settings_;
+    const std::shared_ptr<AVProducer> producer_;
+    const std::size_t                 capacity_;
+
+    mutable std::mutex mutex_;
+    std::deque<Frame>  frames_; // Taken from the producer and not yet returned to every subscriber.
+    int64_t            first_       = 0;
+    int                subscribers_ = 0;
+    bool               shared_      = false;
+    int64_t            lagged_      = 0;
+
+    Impl(Settings settings, std::shared_ptr<AVProducer> producer)
+        : settings_(std::move(settings))
+        , producer_(std::move(producer))
+        , capacity_(std::max(1, env::properties().get(L"ffmpeg.producer.session-window", 8)))
+    {
+    }
+
+    static std::mutex& registry_mutex()
+    {
+        static std::mutex mutex;
+        return mutex;
+    }
+
+    // Sessions others may still join, i.e. which have not returned a frame yet.
+    static std::map<std::string, std::weak_ptr<Impl>>& registry()
+    {
+        static std::map<std::string, std::weak_ptr<Impl>> registry;
+        return registry;
+    }
+
+    static void unregister(const std::shared_ptr<Impl>& impl)
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex());
+
+        auto it = registry().find(impl->settings_.key());
+        if (it != registry().end() && it->second.lock() == impl) {
+            registry().erase(it);
+        }
+    }
+};
+
+AVSession::AVSession(std::shared_ptr<core::frame_factory> frame_factory,
+                     core::video_format_desc              format_desc,
+                     std::string                          name,
+                     std::string                          path,
+                     boost::optional<std::string>         vfilter,
+                     boost::optional<std::string>         afilter,
+                     boost::optional<int64_t>             start,
+                     boost::optional<int64_t>             duration,
+                     boost::optional<bool>                loop)
+{
+    Settings settings{std::move(frame_factory),
+                      std::move(format_desc),
+                      std::move(name),
+                      std::move(path),
+                      std::move(vfilter),
+                      std::move(afilter),
+                      std::move(start),
+                      std::move(duration),
+                      std::move(loop)};
+
+    if (!env::properties().get(L"ffmpeg.producer.shared-decode", true)) {
+        impl_               = std::make_shared<Impl>(settings, settings.open());
+        impl_->subscribers_ = 1;
+        return;
+    }
+
+    const auto key = settings.key();
+
+    std::lock_guard<std::mutex> lock(Impl::registry_mutex());
+
+    auto& registry = Impl::registry();
+    for (auto it = registry.begin(); it != registry.end();) {
+        it = it->second.expired() ? registry.erase(it) : std::next(it);
+    }
+
+    auto it = registry.find(key);
+    if (it != registry.end()) {
+        auto impl = it->second.lock();
+
+        std::lock_guard<std::mutex> impl_lock(impl->mutex_);
+        if (impl->shared_ && impl->first_ == 0 && impl->frames_.empty()) {
+            impl->subscribers_ += 1;
+            impl_ = std::move(impl);
+
+            CASPAR_LOG(info) << L"ffmpeg[" << u16(impl_->settings_.name) << L"] Sharing decoder with "
+                             << impl_->subscribers_ - 1 << L" other producer(s).";
+            return;
+        }
+    }
+
+    impl_               = std::make_shared<Impl>(settings, settings.open());
+    impl_->subscribers_ = 1;
+    impl_->shared_      = true;
+    registry[key]       = impl_;
+}
+
+AVSession::~AVSession()
+{
+    std::lock_guard<std::mutex> lock(impl_->mutex_);
+    impl_->subscribers_ -= 1;
+}
+
+core::draw_frame AVSession::prev_frame()
+{
+    if (!frame_ || flush_) {
+        auto frame = impl_->producer_->prev_frame();
+        if (frame) {
+            frame_ = frame;
+            flush_ = false;
+        }
+    }
+    return core::draw_frame::still(frame_);
+}
+
+core::draw_frame AVSession::next_frame(bool offline)
+{
+    bool lagging = false;
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex_);
+        if (cursor_ < impl_->first_) {
+            impl_->lagged_ += 1;
+            lagging = true;
+        }
+    }
+
+    // A subscriber which fell behind by more than the window, e.g. while paused, continues from where it is on a
+    // decoder of its own instead of skipping the frames it missed.
+    if (lagging) {
+        CASPAR_LOG(info) << L"ffmpeg[" << u16(impl_->settings_.name) << L"] Fell behind the shared decoder.";
+        detach();
+    }
+
+    bool taken = false;
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex_);
+
+        if (cursor_ == impl_->first_ + static_cast<int64_t>(impl_->frames_.size())) {
+            auto frame = impl_->producer_->next_frame(offline);
+            if (!frame) {
+                return frame;
+            }
+
+            taken = impl_->first_ == 0 && impl_->frames_.empty();
+
+            impl_->frames_.push_back(Impl::Frame{std::move(frame), impl_->producer_->time()});
+            while (impl_->frames_.size() > impl_->capacity_) {
+                impl_->frames_.pop_front();
+                impl_->first_ += 1;
+            }
+        }
+
+        const auto& held = impl_->frames_[cursor_ - impl_->first_];
+        frame_           = held.frame;
+        time_            = held.time;
+        flush_           = false;
+        cursor_ += 1;
+    }
+
+    // Nobody joins a session which has moved on, they would start late.
+    if (taken) {
+        Impl::unregister(impl_);
+    }
+
+    return frame_;
+}
+
+const AVProducer& AVSession::producer() const { return *impl_->producer_; }
+
+AVProducer& AVSession::detach()
+{
+    Impl::unregister(impl_);
+
+    std::unique_lock<std::mutex> lock(impl_->mutex_);
+
+    flush_ = true;
+
+    // Where this subscriber is, which is behind the decoder if others are ahead of it.
+    const auto time = time_.value_or(impl_->producer_->time());
+
+    if (impl_->subscribers_ > 1) {
+        impl_->subscribers_ -= 1;
+
+        auto settings = impl_->settings_;
+        lock.unlock();
+
+        impl_ = std::make_shared<Impl>(settings, settings.open());
+        impl_->producer_->seek(time);
+        impl_->subscribers_ = 1;
+        cursor_             = 0;
+
+        CASPAR_LOG(info) << L"ffmpeg[" << u16(settings.name) << L"] Stopped sharing decoder.";
+    } else if (cursor_ < impl_->first_) {
+        // The others left after this one fell behind, the frames it missed are gone.
+        impl_->frames_.clear();
+        impl_->first_ = cursor_;
+        impl_->producer_->seek(time);
+    }
+
+    impl_->shared_ = false;
+    time_          = boost::none;
+    return *impl_->producer_;
+}
+
+core::monitor::state AVSession::state() const
+{
+    auto state = impl_->producer_->state();
+
+    std::lock_guard<std::mutex> lock(impl_->mutex_);
+    state["session/subscribers"] = impl_->subscribers_;
+    state["session/lagged"]      = impl_->lagged_;
+    return state;
+}
+
+}} // namespace caspar::ffmpeg
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "av_producer.h"
+
+#include <core/frame/draw_frame.h>
+#include <core/frame/frame_factory.h>
+#include <core/monitor/monitor.h>
+#include <core/video_format.h>
+
+#include <boost/optional.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace caspar { namespace ffmpeg {
+
+// A subscription to the decoding of a clip. Producers playing the same file with the same filters, in/out points,
+// loop and channel format share one AVProducer, and with it the same frames, as long as they subscribe before the
+// first frame is taken. The decoder stops when the last subscriber is gone.
+class AVSession
+{
+  public:
+    AVSession(std::shared_ptr<core::frame_factory> frame_factory,
+              core::video_format_desc              format_desc,
+              std::string                          name,
+              std::string                          path,
+              boost::optional<std::string>         vfilter,
+              boost::optional<std::string>         afilter,
+              boost::optional<int64_t>             start,
+              boost::optional<int64_t>             duration,
+              boost::optional<bool>                loop);
+    ~AVSession();
+
+    AVSession(const AVSession&) = delete;
+    AVSession& operator=(const AVSession&) = delete;
+
+    core::draw_frame prev_frame();
+    core::draw_frame next_frame(bool offline = false);
+
+    const AVProducer& producer() const;
+
+    // Continues on a decoder of its own if the current one is shared, so that it can be changed without affecting
+    // the other subscribers.
+    AVProducer& detach();
+
+    caspar::core::monitor::state state() const;
+
+  private:
+    struct Impl;
+    std::shared_ptr<Impl> impl_;
+    int64_t                  cursor_ = 0;
+    core::draw_frame         frame_;
+    boost::optional<int64_t> time_; // Of frame_, as it was taken from the producer.
+    bool                     flush_ = false;
+};
+
+}} // namespace caspar::ffmpeg
@@ -23,12 +23,16 @@
 
 #include "ffmpeg_producer.h"
 
+#include "av_frame_cache.h"
 #include "av_producer.h"
+#include "av_session.h"
+#include "playlist_producer.h"
 
 #include <common/env.h>
 #include <common/os/filesystem.h>
 #include <common/param.h>
 
+#include <core/destroyer.h>
 #include <core/frame/draw_frame.h>
 #include <core/frame/frame_factory.h>
 #include <core/producer/frame_producer.h>
@@ -37,8 +41,12 @@
 #include <boost/algorithm/string/predicate.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/logic/tribool.hpp>
+#include <boost/property_tree/ptree.hpp>
 
+#include <atomic>
+#include <cmath>
 #include <cstdint>
+#include <mutex>
 
 #pragma warning(push, 1)
 
@@ -57,41 +65,60 @@ using namespace std::chrono_literals;
 struct ffmpeg_producer : public core::frame_producer
 {
     const std::wstring                   filename_;
+    const std::wstring                   name_;
+    const std::wstring                   vfilter_;
+    const std::wstring                   afilter_;
+    const bool                           speed_audio_;
     spl::shared_ptr<core::frame_factory> frame_factory_;
     core::video_format_desc              format_desc_;
 
-    std::shared_ptr<AVProducer> producer_;
+    const std::shared_ptr<const std::atomic<bool>> offline_;
+    std::shared_ptr<AVSession>                     session_;
+
+    // At other speeds than 1 frames come from cache_ rather than session_, position_ is the playhead.
+    mutable std::mutex            speed_mutex_;
+    double                        speed_    = 1.0;
+    double                        position_ = 0.0;
+    std::shared_ptr<AVFrameCache> cache_;
+    core::draw_frame              speed_frame_;
 
   public:
-    explicit ffmpeg_producer(spl::shared_ptr<core::frame_factory> frame_factory,
-                             core::video_format_desc              format_desc,
-                             std::wstring                         path,
-                             std::wstring                         filename,
-                             std::wstring                         vfilter,
-                             std::wstring                         afilter,
-                             boost::optional<int64_t>             start,
-                             boost::optional<int64_t>             duration,
-                             boost::optional<bool>                loop)
+    explicit ffmpeg_producer(spl::shared_ptr<core::frame_factory>     frame_factory,
+                             core::video_format_desc                  format_desc,
+                             std::wstring                             path,
+                             std::wstring                             filename,
+                             std::wstring                             vfilter,
+                             std::wstring                             afilter,
+                             boost::optional<int64_t>                 start,
+                             boost::optional<int64_t>                 duration,
+                             boost::optional<bool>                    loop,
+                             std::shared_ptr<const std::atomic<bool>> offline)
         : format_desc_(format_desc)
         , filename_(filename)
+        , name_(path)
+        , vfilter_(vfilter)
+        , afilter_(afilter)
+        , speed_audio_(env::properties().get(L"ffmpeg.producer.speed-audio", false))
         , frame_factory_(frame_factory)
-        , producer_(new AVProducer(frame_factory_,
-                                   format_desc_,
-                                   u8(path),
-                                   u8(filename),
-                                   u8(vfilter),
-                                   u8(afilter),
-                                   start,
-                                   duration,
-                                   loop))
+        , offline_(std::move(offline))
+        , session_(new AVSession(frame_factory_,
+                                 format_desc_,
+                                 u8(path),
+                                 u8(filename),
+                                 u8(vfilter),
+                                 u8(afilter),
+                                 start,
+                                 duration,
+                                 loop))
     {
     }
 
     ~ffmpeg_producer()
     {
-        std::thread([producer = std::move(producer_)]() mutable {
+        std::thread([session = std::move(session_), cache = std::move(cache_)]() mutable {
             try {
-                producer.reset();
+                cache.reset();
+                session.reset();
             } catch (...) {
                 CASPAR_LOG_CURRENT_EXCEPTION();
             }
@@ -101,19 +128,111 @@ struct ffmpeg_producer : public core::frame_producer
 
     // frame_producer
 
-    core::draw_frame last_frame() override { return producer_->prev_frame(); }
+    core::draw_frame last_frame() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(speed_mutex_);
+            if (speed_ != 1.0 && speed_frame_) {
+                return core::draw_frame::still(speed_frame_);
+            }
+        }
+        return session_->prev_frame();
+    }
 
-    core::draw_frame receive_impl(int nb_samples) override { return producer_->next_frame(); }
+    core::draw_frame receive_impl(int nb_samples) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(speed_mutex_);
+            if (speed_ != 1.0) {
+                return receive_speed();
+            }
+        }
+        return session_->next_frame(*offline_);
+    }
 
-    std::uint32_t frame_number() const override
+    // Called with speed_mutex_ held.
+    core::draw_frame receive_speed()
     {
-        return static_cast<std::uint32_t>(producer_->time() - producer_->start());
+        const auto start    = producer().start();
+        const auto duration = producer().duration();
+        const auto end      = duration != std::numeric_limits<int64_t>::max() ? start + duration : duration;
+
+        if (position_ < start || position_ >= end) {
+            if (!producer().loop() || end == std::numeric_limits<int64_t>::max()) {
+                position_ = std::max<double>(start, std::min<double>(position_, end - 1));
+                return core::draw_frame::still(speed_frame_);
+            }
+            position_ = speed_ < 0.0 ? end - 1 : start;
+        }
+
+        auto frame = cache_->get(static_cast<int64_t>(std::floor(position_)), speed_);
+        if (!frame) {
+            // Holds the playhead until the frame is decoded.
+            return core::draw_frame{};
+        }
+
+        position_ += speed_;
+        speed_frame_ = frame;
+
+        return speed_audio_ && speed_ > 0.0 ? frame : core::draw_frame::still(frame);
+    }
+
+    void speed(double speed)
+    {
+        speed = std::max(-4.0, std::min(speed, 4.0));
+
+        std::lock_guard<std::mutex> lock(speed_mutex_);
+
+        if (speed_ == 1.0 && speed != 1.0) {
+            position_ = static_cast<double>(producer().time());
+            if (!cache_) {
+                cache_ = std::make_shared<AVFrameCache>(
+                    frame_factory_, format_desc_, u8(name_), u8(filename_), u8(vfilter_), u8(afilter_));
+            }
+        } else if (speed_ != 1.0 && speed == 1.0) {
+            session_->detach().seek(static_cast<int64_t>(std::floor(position_)));
+        }
+
+        speed_ = speed;
     }
 
+    void format_desc(const core::video_format_desc& format_desc) override
+    {
+        // Called on every load. A decoder shared with other layers and the frame cache are only given up for a real
+        // change.
+        if (format_desc == format_desc_) {
+            return;
+        }
+        format_desc_ = format_desc;
+        session_->detach().format_desc(format_desc);
+
+        std::lock_guard<std::mutex> lock(speed_mutex_);
+        if (cache_) {
+            // Stopping the cache's decoders blocks, do it off the channel thread.
+            core::destroyer::instance().destroy(L"ffmpeg[" + filename_ + L"] cache", std::move(cache_));
+
+            // At normal speed the cache is rebuilt when next needed, see speed().
+            if (speed_ != 1.0) {
+                cache_ = std::make_shared<AVFrameCache>(
+                    frame_factory_, format_desc_, u8(name_), u8(filename_), u8(vfilter_), u8(afilter_));
+            }
+        }
+    }
+
+    const AVProducer& producer() const { return session_->producer(); }
+
+    int64_t time() const
+    {
+        std::lock_guard<std::mutex> lock(speed_mutex_);
+        return speed_ != 1.0 ? static_cast<int64_t>(std::floor(position_)) : producer().time();
+    }
+
+    std::uint32_t frame_number() const override { return static_cast<std::uint32_t>(time() - producer().start()); }
+
     std::uint32_t nb_frames() const override
     {
-        return producer_->loop() ? std::numeric_limits<std::uint32_t>::max()
-                                 : static_cast<std::uint32_t>(producer_->duration());
+        return producer().loop() ? std::numeric_limits<std::uint32_t>::max()
+                                 : static_cast<std::uint32_t>(producer().duration());
     }
 
     std::future<std::wstring> call(const std::vector<std::wstring>& params) override
@@ -128,38 +247,38 @@ struct ffmpeg_producer : public core::frame_producer
 
         if (boost::iequals(cmd, L"loop")) {
             if (!value.empty()) {
-                producer_->loop(boost::lexical_cast<bool>(value));
+                session_->detach().loop(boost::lexical_cast<bool>(value));
             }
 
-            result = boost::lexical_cast<std::wstring>(producer_->loop());
+            result = boost::lexical_cast<std::wstring>(producer().loop());
         } else if (boost::iequals(cmd, L"in") || boost::iequals(cmd, L"start")) {
             if (!value.empty()) {
-                producer_->start(boost::lexical_cast<int64_t>(value));
+                session_->detach().start(boost::lexical_cast<int64_t>(value));
             }
 
-            result = boost::lexical_cast<std::wstring>(producer_->start());
+            result = boost::lexical_cast<std::wstring>(producer().start());
         } else if (boost::iequals(cmd, L"out")) {
             if (!value.empty()) {
-                producer_->duration(boost::lexical_cast<int64_t>(value) - producer_->start());
+                session_->detach().duration(boost::lexical_cast<int64_t>(value) - producer().start());
             }
 
-            result = boost::lexical_cast<std::wstring>(producer_->start() + producer_->duration());
+            result = boost::lexical_cast<std::wstring>(producer().start() + producer().duration());
         } else if (boost::iequals(cmd, L"length")) {
             if (!value.empty()) {
-                producer_->duration(boost::lexical_cast<std::int64_t>(value));
+                session_->detach().duration(boost::lexical_cast<std::int64_t>(value));
             }
 
-            result = boost::lexical_cast<std::wstring>(producer_->duration());
+            result = boost::lexical_cast<std::wstring>(producer().duration());
         } else if (boost::iequals(cmd, L"seek") && !value.empty()) {
             int64_t seek;
             if (boost::iequals(value, L"rel")) {
-                seek = producer_->time();
+                seek = time();
             } else if (boost::iequals(value, L"in")) {
-                seek = producer_->start();
+                seek = producer().start();
             } else if (boost::iequals(value, L"out")) {
-                seek = producer_->start() + producer_->duration();
+                seek = producer().start() + producer().duration();
             } else if (boost::iequals(value, L"end")) {
-                seek = producer_->duration();
+                seek = producer().duration();
             } else {
                 seek = boost::lexical_cast<int64_t>(value);
             }
@@ -168,9 +287,20 @@ struct ffmpeg_producer : public core::frame_producer
                 seek += boost::lexical_cast<int64_t>(params.at(2));
             }
 
-            producer_->seek(seek);
+            session_->detach().seek(seek);
+            {
+                std::lock_guard<std::mutex> lock(speed_mutex_);
+                position_ = static_cast<double>(seek);
+            }
 
             result = boost::lexical_cast<std::wstring>(seek);
+        } else if (boost::iequals(cmd, L"speed")) {
+            if (!value.empty()) {
+                speed(boost::lexical_cast<double>(value));
+            }
+
+            std::lock_guard<std::mutex> lock(speed_mutex_);
+            result = boost::lexical_cast<std::wstring>(speed_);
         } else {
             CASPAR_THROW_EXCEPTION(invalid_argument());
         }
@@ -182,13 +312,25 @@ struct ffmpeg_producer : public core::frame_producer
 
     std::wstring print() const override
     {
-        return L"ffmpeg[" + filename_ + L"|" + boost::lexical_cast<std::wstring>(producer_->time()) + L"/" +
-               boost::lexical_cast<std::wstring>(producer_->duration()) + L"]";
+        return L"ffmpeg[" + filename_ + L"|" + boost::lexical_cast<std::wstring>(time()) + L"/" +
+               boost::lexical_cast<std::wstring>(producer().duration()) + L"]";
     }
 
     std::wstring name() const override { return L"ffmpeg"; }
 
-    core::monitor::state state() const override { return producer_->state(); }
+    core::monitor::state state() const override
+    {
+        auto state = session_->state();
+
+        std::lock_guard<std::mutex> lock(speed_mutex_);
+        state["speed"] = speed_;
+        if (cache_) {
+            for (auto& p : cache_->state()) {
+                state[p.first] = p.second;
+            }
+        }
+        return state;
+    }
 };
 
 boost::tribool has_valid_extension(const std::wstring& filename)
@@ -295,6 +437,10 @@ std::wstring probe_stem(const std::wstring& stem)
 spl::shared_ptr<core::frame_producer> create_producer(const core::frame_producer_dependencies& dependencies,
                                                       const std::vector<std::wstring>&         params)
 {
+    if (boost::iequals(params.at(0), L"[PLAYLIST]")) {
+        return create_playlist_producer(dependencies, params);
+    }
+
     auto name = params.at(0);
     auto path = name;
 
@@ -343,8 +489,17 @@ spl::shared_ptr<core::frame_producer> create_producer(const core::frame_producer
     auto afilter = boost::to_lower_copy(get_param(L"AF", params, get_param(L"FILTER", params, L"")));
 
     try {
-        auto producer = spl::make_shared<ffmpeg_producer>(
-            dependencies.frame_factory, dependencies.format_desc, name, path, vfilter, afilter, start, duration, loop);
+        auto producer = spl::make_shared<ffmpeg_producer>(dependencies.frame_factory,
+                                                          dependencies.format_desc,
+                                                          name,
+                                                          path,
+                                                          vfilter,
+                                                          afilter,
+                                                          start,
+                                                          duration,
+                                                          loop,
+                                                          dependencies.offline);
+        producer->speed(get_param(L"SPEED", params, 1.0));
         return core::create_destroy_proxy(std::move(producer));
     } catch (...) {
         CASPAR_LOG_CURRENT_EXCEPTION();
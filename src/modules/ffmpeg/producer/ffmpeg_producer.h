@@ -30,6 +30,12 @@
 
 namespace caspar { namespace ffmpeg {
 
+/**
+ * @return The file in the folder of stem whose name without extension is the
+ *         name of stem and which ffmpeg can read, or an empty string.
+ */
+std::wstring probe_stem(const std::wstring& stem);
+
 spl::shared_ptr<core::frame_producer> create_producer(const core::frame_producer_dependencies& dependencies,
                                                       const std::vector<std::wstring>&         params);
 
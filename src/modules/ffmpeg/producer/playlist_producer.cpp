@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+
+#include "../StdAfx.h"
+
+#include "playlist_producer.h"
+
+#include "av_producer.h"
+#include "ffmpeg_producer.h"
+
+#include <common/env.h>
+#include <common/except.h>
+#include <common/future.h>
+#include <common/log.h>
+#include <common/param.h>
+#include <common/utf.h>
+
+#include <core/destroyer.h>
+#include <core/frame/draw_frame.h>
+#include <core/frame/frame_factory.h>
+#include <core/monitor/monitor.h>
+#include <core/producer/frame_producer.h>
+#include <core/video_format.h>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+
+namespace caspar { namespace ffmpeg {
+
+struct playlist_producer : public core::frame_producer
+{
+    struct item
+    {
+        std::wstring name;
+        std::wstring path;
+    };
+
+    struct open_item
+    {
+        std::size_t                 index;
+        std::shared_ptr<AVProducer> producer;
+    };
+
+    const spl::shared_ptr<core::frame_factory>     frame_factory_;
+    const std::vector<item>                        items_;
+    const std::wstring                             vfilter_;
+    const std::wstring                             afilter_;
+    const std::size_t                              preroll_;
+    const std::shared_ptr<const std::atomic<bool>> offline_;
+
+    mutable std::mutex      mutex_;
+    core::video_format_desc format_desc_;
+    bool                    loop_;
+    std::deque<open_item>   open_; // The playing item first, then the prerolling ones in playing order.
+    core::draw_frame        frame_;
+    uint32_t                frame_number_ = 0;
+    int64_t                 splices_      = 0;
+    int64_t                 late_         = 0;
+
+    playlist_producer(const spl::shared_ptr<core::frame_factory>& frame_factory,
+                      const core::video_format_desc&              format_desc,
+                      std::vector<item>                           items,
+                      std::wstring                                vfilter,
+                      std::wstring                                afilter,
+                      std::size_t                                 preroll,
+                      bool                                        loop,
+                      std::shared_ptr<const std::atomic<bool>>    offline)
+        : frame_factory_(frame_factory)
+        , items_(std::move(items))
+        , vfilter_(std::move(vfilter))
+        , afilter_(std::move(afilter))
+        , preroll_(preroll)
+        , offline_(std::move(offline))
+        , format_desc_(format_desc)
+        , loop_(loop)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        open_.push_back(open_item{0, open(0)});
+        prepare();
+
+        CASPAR_LOG(info) << print_impl() << L" Initialized";
+    }
+
+    ~playlist_producer()
+    {
+        for (auto& item : open_) {
+            core::destroyer::instance().destroy(L"playlist[" + items_[item.index].name + L"]",
+                                                std::move(item.producer));
+        }
+    }
+
+    std::shared_ptr<AVProducer> open(std::size_t index) const
+    {
+        return std::make_shared<AVProducer>(frame_factory_,
+                                            format_desc_,
+                                            u8(items_[index].name),
+                                            u8(items_[index].path),
+                                            u8(vfilter_),
+                                            u8(afilter_),
+                                            boost::none,
+                                            boost::none,
+                                            false);
+    }
+
+    // Called with mutex_ held. Opens the items following the playing one, decoding starts right away and stops once
+    // their buffers are full.
+    void prepare()
+    {
+        while (!open_.empty() && open_.size() <= preroll_) {
+            auto index = open_.back().index + 1;
+            if (index >= items_.size()) {
+                if (!loop_) {
+                    break;
+                }
+                index = 0;
+            }
+            // A short playlist does not open the same item twice, the playing one is reopened once it ended.
+            if (index == open_.front().index) {
+                break;
+            }
+            open_.push_back(open_item{index, open(index)});
+        }
+    }
+
+    // Called with mutex_ held. Moves to the next item once the playing one has returned its last frame, or right away
+    // if skip is set. Items which ended without a frame, e.g. unreadable files, are passed over.
+    void splice(bool skip = false)
+    {
+        for (std::size_t n = 0; n < items_.size() && !open_.empty() && (skip || open_.front().producer->eof()); ++n) {
+            skip = false;
+
+            auto ended = std::move(open_.front());
+            open_.pop_front();
+
+            if (open_.empty() && loop_) {
+                const auto index = (ended.index + 1) % items_.size();
+                open_.push_back(open_item{index, open(index)});
+            }
+
+            core::destroyer::instance().destroy(L"playlist[" + items_[ended.index].name + L"]",
+                                                std::move(ended.producer));
+
+            prepare();
+
+            if (open_.empty()) {
+                CASPAR_LOG(info) << print_impl() << L" Ended";
+                return;
+            }
+
+            splices_ += 1;
+            if (!open_.front().producer->ready()) {
+                late_ += 1;
+                CASPAR_LOG(warning) << print_impl() << L" " << items_[open_.front().index].name
+                                    << L" was not prerolled in time.";
+            }
+        }
+    }
+
+    // frame_producer
+
+    core::draw_frame receive_impl(int nb_samples) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        splice();
+
+        if (open_.empty()) {
+            return core::draw_frame::still(frame_);
+        }
+
+        auto frame = open_.front().producer->next_frame(*offline_);
+        if (frame) {
+            frame_ = frame;
+            frame_number_ += 1;
+        }
+        return frame;
+    }
+
+    core::draw_frame last_frame() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (!frame_ && !open_.empty()) {
+            return open_.front().producer->prev_frame();
+        }
+        return core::draw_frame::still(frame_);
+    }
+
+    void format_desc(const core::video_format_desc& format_desc) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        format_desc_ = format_desc;
+        for (auto& item : open_) {
+            item.producer->format_desc(format_desc);
+        }
+    }
+
+    uint32_t frame_number() const override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return frame_number_;
+    }
+
+    uint32_t nb_frames() const override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Durations are known for open items only, i.e. once the end of the playlist is within the preroll.
+        if (loop_ || open_.empty() || open_.back().index + 1 < items_.size()) {
+            return open_.empty() ? frame_number_ : std::numeric_limits<uint32_t>::max();
+        }
+
+        int64_t remaining = 0;
+        for (auto& item : open_) {
+            auto duration = item.producer->duration();
+            if (duration == std::numeric_limits<int64_t>::max()) {
+                return std::numeric_limits<uint32_t>::max();
+            }
+            remaining += duration;
+        }
+        remaining -= open_.front().producer->time() - open_.front().producer->start();
+
+        return static_cast<uint32_t>(
+            std::min<int64_t>(frame_number_ + std::max<int64_t>(0, remaining), std::numeric_limits<uint32_t>::max()));
+    }
+
+    std::future<std::wstring> call(const std::vector<std::wstring>& params) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        std::wstring result;
+
+        std::wstring cmd = params.at(0);
+        std::wstring value;
+        if (params.size() > 1) {
+            value = params.at(1);
+        }
+
+        if (boost::iequals(cmd, L"loop")) {
+            if (!value.empty()) {
+                loop_ = boost::lexical_cast<bool>(value);
+                prepare();
+            }
+
+            result = boost::lexical_cast<std::wstring>(loop_);
+        } else if (boost::iequals(cmd, L"next")) {
+            // Cuts to the next item on the following frame.
+            splice(true);
+
+            result = open_.empty() ? L"" : boost::lexical_cast<std::wstring>(open_.front().index);
+        } else if (boost::iequals(cmd, L"index")) {
+            result = open_.empty() ? L"" : boost::lexical_cast<std::wstring>(open_.front().index);
+        } else {
+            CASPAR_THROW_EXCEPTION(invalid_argument());
+        }
+
+        return make_ready_future(std::move(result));
+    }
+
+    core::monitor::state state() const override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto state = open_.empty() ? core::monitor::state() : open_.front().producer->state();
+
+        state["loop"]             = loop_;
+        state["playlist/index"]   = open_.empty() ? -1 : static_cast<int>(open_.front().index);
+        state["playlist/count"]   = static_cast<int>(items_.size());
+        state["playlist/preroll"] = static_cast<int>(preroll_);
+        state["playlist/splices"] = splices_;
+        state["playlist/late"]    = late_;
+        for (std::size_t n = 0; n < items_.size(); ++n) {
+            state["playlist/items/" + boost::lexical_cast<std::string>(n) + "/name"] = u8(items_[n].name);
+        }
+        for (auto& item : open_) {
+            const auto prefix        = "playlist/items/" + boost::lexical_cast<std::string>(item.index);
+            state[prefix + "/open"]  = true;
+            state[prefix + "/ready"] = item.producer->ready();
+        }
+        return state;
+    }
+
+    std::wstring print_impl() const
+    {
+        return L"playlist[" + (open_.empty() ? std::wstring(L"-") : items_[open_.front().index].name) + L"|" +
+               boost::lexical_cast<std::wstring>(open_.empty() ? items_.size() : open_.front().index + 1) + L"/" +
+               boost::lexical_cast<std::wstring>(items_.size()) + L"]";
+    }
+
+    std::wstring print() const override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return print_impl();
+    }
+
+    std::wstring name() const override { return L"playlist"; }
+};
+
+spl::shared_ptr<core::frame_producer> create_playlist_producer(const core::frame_producer_dependencies& dependencies,
+                                                               const std::vector<std::wstring>&         params)
+{
+    static const auto keywords = {L"LOOP", L"PREROLL", L"FILTER", L"VF", L"AF"};
+
+    std::vector<playlist_producer::item> items;
+
+    for (std::size_t n = 1; n < params.size(); ++n) {
+        const auto& name = params.at(n);
+
+        if (std::any_of(keywords.begin(), keywords.end(), [&](const wchar_t* keyword) {
+                return boost::iequals(name, keyword);
+            })) {
+            break;
+        }
+
+        auto path = name;
+        if (!boost::contains(path, L"://")) {
+            path = boost::filesystem::path(probe_stem(env::media_folder() + L"/" + path)).generic_wstring();
+        }
+
+        if (path.empty()) {
+            CASPAR_LOG(warning) << L"playlist[] " << name << L" not found, skipping.";
+            continue;
+        }
+
+        items.push_back(playlist_producer::item{name, path});
+    }
+
+    if (items.empty()) {
+        return core::frame_producer::empty();
+    }
+
+    auto loop    = contains_param(L"LOOP", params);
+    auto preroll = get_param(L"PREROLL", params, env::properties().get(L"ffmpeg.producer.playlist-preroll", 2u));
+
+    auto filter_str = get_param(L"FILTER", params, L"");
+
+    boost::ireplace_all(filter_str, L"DEINTERLACE_BOB", L"YADIF=1:-1");
+    boost::ireplace_all(filter_str, L"DEINTERLACE_LQ", L"SEPARATEFIELDS");
+    boost::ireplace_all(filter_str, L"DEINTERLACE", L"YADIF=0:-1");
+
+    auto vfilter = boost::to_lower_copy(get_param(L"VF", params, filter_str));
+    auto afilter = boost::to_lower_copy(get_param(L"AF", params, get_param(L"FILTER", params, L"")));
+
+    try {
+        auto producer = spl::make_shared<playlist_producer>(dependencies.frame_factory,
+                                                            dependencies.format_desc,
+                                                            std::move(items),
+                                                            vfilter,
+                                                            afilter,
+                                                            std::max(1u, preroll),
+                                                            loop,
+                                                            dependencies.offline);
+        return core::create_destroy_proxy(std::move(producer));
+    } catch (...) {
+        CASPAR_LOG_CURRENT_EXCEPTION();
+    }
+    return core::frame_producer::empty();
+}
+
+}} // namespace caspar::ffmpeg
@@ -16,10 +16,155 @@ extern "C" {
 #pragma warning(pop)
 #endif
 
+#include <common/env.h>
+
+#include <boost/property_tree/ptree.hpp>
+
 #include <tbb/parallel_for.h>
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
 namespace caspar { namespace ffmpeg {
 
+namespace {
+
+// Recycles the audio buffers of released frames, so that steady playback does not allocate per frame.
+struct AudioPool
+{
+    std::mutex                                         mutex;
+    std::vector<std::unique_ptr<std::vector<int32_t>>> buffers;
+};
+
+array<int32_t> alloc_audio(std::size_t size)
+{
+    static const auto pool = std::make_shared<AudioPool>();
+
+    std::unique_ptr<std::vector<int32_t>> buffer;
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        if (!pool->buffers.empty()) {
+            buffer = std::move(pool->buffers.back());
+            pool->buffers.pop_back();
+        }
+    }
+    if (!buffer) {
+        buffer.reset(new std::vector<int32_t>());
+    }
+    buffer->resize(size);
+
+    std::weak_ptr<AudioPool> weak_pool = pool;
+    auto storage = std::shared_ptr<std::vector<int32_t>>(buffer.release(), [weak_pool](std::vector<int32_t>* ptr) {
+        auto buffer = std::unique_ptr<std::vector<int32_t>>(ptr);
+        auto pool   = weak_pool.lock();
+        if (pool) {
+            std::lock_guard<std::mutex> lock(pool->mutex);
+            if (pool->buffers.size() < 64) {
+                pool->buffers.push_back(std::move(buffer));
+            }
+        }
+    });
+
+    return array<int32_t>(storage->data(), storage->size(), std::move(storage));
+}
+
+// Output channel n takes source channel map[n], negative entries are silent. The configured map is a comma separated
+// list of source channels, e.g. "0,1,0,1" to copy stereo to the first four channels. By default source channels are
+// passed through in order.
+std::vector<int> channel_map(int src_channels, int dst_channels)
+{
+    static const auto config = [] {
+        std::vector<int> result;
+
+        std::wstringstream stream(env::properties().get(L"ffmpeg.producer.audio-channel-map", std::wstring()));
+        std::wstring       item;
+        while (std::getline(stream, item, L',')) {
+            wchar_t* end = nullptr;
+            auto     ch  = static_cast<int>(std::wcstol(item.c_str(), &end, 10));
+            result.push_back(end != item.c_str() ? ch : -1);
+        }
+        return result;
+    }();
+
+    std::vector<int> map(dst_channels, -1);
+    for (int n = 0; n < dst_channels; ++n) {
+        auto ch = config.empty() ? n : n < static_cast<int>(config.size()) ? config[n] : -1;
+        map[n]  = ch < src_channels ? ch : -1;
+    }
+    return map;
+}
+
+void route_audio(int32_t*                dst,
+                 int                     dst_channels,
+                 const int32_t*          src,
+                 int                     src_channels,
+                 const std::vector<int>& map,
+                 int                     nb_samples)
+{
+    for (int n = 0; n < nb_samples; ++n, dst += dst_channels, src += src_channels) {
+        for (int ch = 0; ch < dst_channels; ++ch) {
+            dst[ch] = map[ch] < 0 ? 0 : src[map[ch]];
+        }
+    }
+}
+
+void convert_audio(int32_t* dst, int dst_channels, const int32_t* src, int src_channels, int nb_samples)
+{
+    const auto map = channel_map(src_channels, dst_channels);
+
+    auto passthrough = true;
+    for (int ch = 0; ch < dst_channels; ++ch) {
+        passthrough &= map[ch] == (ch < src_channels ? ch : -1);
+    }
+
+    if (passthrough && src_channels == dst_channels) {
+        std::memcpy(dst, src, static_cast<std::size_t>(nb_samples) * dst_channels * sizeof(int32_t));
+        return;
+    }
+
+    // Mono and stereo into the default 8 channel layout, 4 and 2 samples at a time.
+    const auto zero = _mm_setzero_si128();
+    auto       n    = 0;
+    if (passthrough && dst_channels == 8 && src_channels == 2) {
+        for (; n + 2 <= nb_samples; n += 2) {
+            auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n * 2));
+            auto d = reinterpret_cast<__m128i*>(dst + n * 8);
+            _mm_storeu_si128(d + 0, _mm_unpacklo_epi64(x, zero));
+            _mm_storeu_si128(d + 1, zero);
+            _mm_storeu_si128(d + 2, _mm_unpackhi_epi64(x, zero));
+            _mm_storeu_si128(d + 3, zero);
+        }
+    } else if (passthrough && dst_channels == 8 && src_channels == 1) {
+        const auto mask = _mm_set_epi32(0, 0, 0, -1);
+        for (; n + 4 <= nb_samples; n += 4) {
+            auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n));
+            auto d = reinterpret_cast<__m128i*>(dst + n * 8);
+            _mm_storeu_si128(d + 0, _mm_and_si128(x, mask));
+            _mm_storeu_si128(d + 1, zero);
+            _mm_storeu_si128(d + 2, _mm_and_si128(_mm_srli_si128(x, 4), mask));
+            _mm_storeu_si128(d + 3, zero);
+            _mm_storeu_si128(d + 4, _mm_and_si128(_mm_srli_si128(x, 8), mask));
+            _mm_storeu_si128(d + 5, zero);
+            _mm_storeu_si128(d + 6, _mm_srli_si128(x, 12));
+            _mm_storeu_si128(d + 7, zero);
+        }
+    }
+
+    route_audio(dst + n * dst_channels, dst_channels, src + n * src_channels, src_channels, map, nb_samples - n);
+}
+
+} // namespace
+
 std::shared_ptr<AVFrame> alloc_frame()
 {
     const auto frame = std::shared_ptr<AVFrame>(av_frame_alloc(), [](AVFrame* ptr) { av_frame_free(&ptr); });
@@ -39,7 +184,8 @@ std::shared_ptr<AVPacket> alloc_packet()
 core::mutable_frame make_frame(void*                    tag,
                                core::frame_factory&     frame_factory,
                                std::shared_ptr<AVFrame> video,
-                               std::shared_ptr<AVFrame> audio)
+                               std::shared_ptr<AVFrame> audio,
+                               int                      audio_channels)
 {
     const auto pix_desc =
         video ? pixel_format_desc(static_cast<AVPixelFormat>(video->format), video->width, video->height)
@@ -58,15 +204,12 @@ core::mutable_frame make_frame(void*                    tag,
     }
 
     if (audio) {
-        // TODO This is a bit of a hack
-        frame.audio_data() = std::vector<int32_t>(audio->nb_samples * 8, 0);
-        auto dst           = frame.audio_data().data();
-        auto src           = reinterpret_cast<int32_t*>(audio->data[0]);
-        tbb::parallel_for(0, audio->nb_samples, [&](int i) {
-            for (auto j = 0; j < std::min(8, audio->channels); ++j) {
-                dst[i * 8 + j] = src[i * audio->channels + j];
-            }
-        });
+        frame.audio_data() = alloc_audio(static_cast<std::size_t>(audio->nb_samples) * audio_channels);
+        convert_audio(frame.audio_data().data(),
+                      audio_channels,
+                      reinterpret_cast<const int32_t*>(audio->data[0]),
+                      audio->channels,
+                      audio->nb_samples);
     }
 
     return frame;
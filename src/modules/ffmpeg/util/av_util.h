@@ -21,10 +21,14 @@ std::shared_ptr<AVPacket> alloc_packet();
 
 core::pixel_format      get_pixel_format(AVPixelFormat pix_fmt);
 core::pixel_format_desc pixel_format_desc(AVPixelFormat pix_fmt, int width, int height);
-core::mutable_frame     make_frame(void*                    tag,
-                                   core::frame_factory&     frame_factory,
-                                   std::shared_ptr<AVFrame> video,
-                                   std::shared_ptr<AVFrame> audio);
+
+// Copies video into a new frame and routes the S32 audio channels into audio_channels interleaved channels, following
+// ffmpeg.producer.audio-channel-map. Audio keeps the source layout up to this point.
+core::mutable_frame make_frame(void*                    tag,
+                               core::frame_factory&     frame_factory,
+                               std::shared_ptr<AVFrame> video,
+                               std::shared_ptr<AVFrame> audio,
+                               int                      audio_channels = 8);
 
 std::shared_ptr<AVFrame> make_av_video_frame(const core::const_frame& frame, const core::video_format_desc& format_des);
 std::shared_ptr<AVFrame> make_av_audio_frame(const core::const_frame& frame, const core::video_format_desc& format_des);
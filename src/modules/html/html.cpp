@@ -37,7 +37,9 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/range/algorithm/remove_if.hpp>
 
+#include <atomic>
 #include <map>
+#include <mutex>
 
 #pragma warning(push)
 #pragma warning(disable : 4458)
@@ -51,6 +53,8 @@
 namespace caspar { namespace html {
 
 std::unique_ptr<executor> g_cef_executor;
+std::once_flag            g_cef_init_once;
+std::atomic<bool>         g_cef_initialized{false};
 
 void caspar_log(const CefRefPtr<CefBrowser>&        browser,
                 boost::log::trivial::severity_level level,
@@ -225,25 +229,42 @@ bool intercept_command_line(int argc, char** argv)
     return CefExecuteProcess(main_args, CefRefPtr<CefApp>(new renderer_application(false)), nullptr) >= 0;
 }
 
-void init(core::module_dependencies dependencies)
+void initialize_cef()
 {
-    dependencies.producer_registry->register_producer_factory(L"HTML Producer", html::create_producer);
+    std::call_once(g_cef_init_once, [] {
+        CASPAR_LOG(info) << L"[html] Initializing CEF.";
 
-    CefMainArgs main_args;
-    g_cef_executor.reset(new executor(L"cef"));
-    g_cef_executor->invoke([&] {
+        CefMainArgs main_args;
+        g_cef_executor.reset(new executor(L"cef"));
+        g_cef_executor->invoke([&] {
 #ifdef WIN32
-        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+            SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
 #endif
-        const bool  enable_gpu = env::properties().get(L"configuration.html.enable-gpu", false);
-        CefSettings settings;
-        settings.command_line_args_disabled   = false;
-        settings.no_sandbox                   = true;
-        settings.remote_debugging_port        = env::properties().get(L"configuration.html.remote-debugging-port", 0);
-        settings.windowless_rendering_enabled = true;
-        CefInitialize(main_args, settings, CefRefPtr<CefApp>(new renderer_application(enable_gpu)), nullptr);
+            const bool  enable_gpu = env::properties().get(L"configuration.html.enable-gpu", false);
+            const int   debug_port = env::properties().get(L"configuration.html.remote-debugging-port", 0);
+            CefSettings settings;
+            settings.command_line_args_disabled   = false;
+            settings.no_sandbox                   = true;
+            settings.remote_debugging_port        = debug_port;
+            settings.windowless_rendering_enabled = true;
+            CefInitialize(main_args, settings, CefRefPtr<CefApp>(new renderer_application(enable_gpu)), nullptr);
+        });
+        g_cef_executor->begin_invoke([&] { CefRunMessageLoop(); });
+
+        g_cef_initialized = true;
     });
-    g_cef_executor->begin_invoke([&] { CefRunMessageLoop(); });
+}
+
+void init(core::module_dependencies dependencies)
+{
+    dependencies.producer_registry->register_producer_factory(L"HTML Producer", html::create_producer);
+
+    // Starting CEF spawns its helper processes and takes seconds, so unless the configuration asks for html it is
+    // deferred until the first html producer is created.
+    if (env::properties().get_child_optional(L"configuration.html")) {
+        initialize_cef();
+    }
+
     dependencies.cg_registry->register_cg_producer(
         L"html",
         {L".html"},
@@ -264,6 +285,10 @@ void init(core::module_dependencies dependencies)
 
 void uninit()
 {
+    if (!g_cef_initialized) {
+        return;
+    }
+
     invoke([] { CefQuitMessageLoop(); });
     g_cef_executor->begin_invoke([&] { CefShutdown(); });
     g_cef_executor.reset();
@@ -304,6 +329,8 @@ void invoke(const std::function<void()>& func) { begin_invoke(func).get(); }
 
 std::future<void> begin_invoke(const std::function<void()>& func)
 {
+    initialize_cef();
+
     CefRefPtr<cef_task> task = new cef_task(func);
 
     if (CefCurrentlyOn(TID_UI)) {
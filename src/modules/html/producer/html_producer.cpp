@@ -50,6 +50,7 @@
 #include <tbb/concurrent_queue.h>
 #include <tbb/parallel_for.h>
 
+#include <cmath>
 #include <mutex>
 
 #pragma warning(push)
@@ -174,6 +175,20 @@ class html_client
         return true;
     }
 
+    // Resizes the view and sets the browser frame rate for a new channel format.
+    void format_desc(const core::video_format_desc& format_desc)
+    {
+        CASPAR_ASSERT(CefCurrentlyOn(TID_UI));
+
+        format_desc_ = format_desc;
+        graph_->set_text(print());
+
+        if (browser_) {
+            browser_->GetHost()->SetWindowlessFrameRate(static_cast<int>(std::ceil(format_desc_.fps)));
+            browser_->GetHost()->WasResized();
+        }
+    }
+
     CefRefPtr<CefBrowserHost> get_browser_host() const
     {
         if (browser_)
@@ -371,6 +386,7 @@ class html_client
 class html_producer : public core::frame_producer
 {
     core::video_format_desc             format_desc_;
+    const bool                          fixed_size_; // The size was given in the url.
     core::monitor::state                state_;
     const std::wstring                  url_;
     spl::shared_ptr<diagnostics::graph> graph_;
@@ -380,8 +396,10 @@ class html_producer : public core::frame_producer
   public:
     html_producer(const spl::shared_ptr<core::frame_factory>& frame_factory,
                   const core::video_format_desc&              format_desc,
-                  const std::wstring&                         url)
+                  const std::wstring&                         url,
+                  bool                                        fixed_size)
         : format_desc_(format_desc)
+        , fixed_size_(fixed_size)
         , url_(url)
     {
         html::invoke([&] {
@@ -425,6 +443,25 @@ class html_producer : public core::frame_producer
 
     core::draw_frame first_frame() override { return receive_impl(0); }
 
+    void format_desc(const core::video_format_desc& format_desc) override
+    {
+        auto desc = format_desc;
+        if (fixed_size_) {
+            desc.width         = format_desc_.width;
+            desc.square_width  = format_desc_.square_width;
+            desc.height        = format_desc_.height;
+            desc.square_height = format_desc_.square_height;
+        }
+        if (desc == format_desc_) {
+            return;
+        }
+        format_desc_ = desc;
+
+        if (client_) {
+            html::invoke([&] { client_->format_desc(desc); });
+        }
+    }
+
     std::future<std::wstring> call(const std::vector<std::wstring>& params) override
     {
         if (!client_)
@@ -480,7 +517,8 @@ spl::shared_ptr<core::frame_producer> create_cg_producer(const core::frame_produ
         format_desc.square_height = *height;
     }
 
-    return core::create_destroy_proxy(spl::make_shared<html_producer>(dependencies.frame_factory, format_desc, url));
+    return core::create_destroy_proxy(
+        spl::make_shared<html_producer>(dependencies.frame_factory, format_desc, url, width && height));
 }
 
 spl::shared_ptr<core::frame_producer> create_producer(const core::frame_producer_dependencies& dependencies,
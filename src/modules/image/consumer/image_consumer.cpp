@@ -31,76 +31,266 @@
 #include <common/array.h>
 #include <common/env.h>
 #include <common/except.h>
+#include <common/executor.h>
 #include <common/future.h>
 #include <common/log.h>
+#include <common/param.h>
+#include <common/timer.h>
 #include <common/utf.h>
 
 #include <core/consumer/frame_consumer.h>
 #include <core/frame/frame.h>
+#include <core/monitor/monitor.h>
 #include <core/video_format.h>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
-#include <tbb/concurrent_queue.h>
+#include <tbb/parallel_for.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
 #include <vector>
 
-#include "../util/image_view.h"
 #include "image/util/image_algorithms.h"
 
 namespace caspar { namespace image {
 
-struct image_consumer : public core::frame_consumer
+enum class snapshot_format
 {
-    std::wstring filename_;
+    png,
+    jpeg,
+    raw
+};
+
+struct snapshot_options
+{
+    snapshot_format format  = snapshot_format::png;
+    int             quality = 0; // zlib level 1..9 for PNG, 1..100 for JPEG, clamped.
+    int             width   = 0;
+    int             height  = 0;
+};
+
+/**
+ * Encodes snapshots on a few persistent threads. At most capacity snapshots
+ * are queued, further ones have to wait for a free slot.
+ */
+class snapshot_encoder
+{
+    std::vector<std::unique_ptr<executor>> executors_;
+    const int                              capacity_;
+    std::atomic<int>                       pending_{0};
+
+    mutable std::mutex mutex_;
+    std::int64_t       encoded_          = 0;
+    std::int64_t       failed_           = 0;
+    std::int64_t       deferred_         = 0;
+    double             last_encode_time_ = 0.0;
+    double             max_encode_time_  = 0.0;
 
   public:
-    // frame_consumer
+    snapshot_encoder()
+        : capacity_(std::max(1, env::properties().get(L"configuration.image.snapshot-queue", 4)))
+    {
+        auto count = std::max(1u, std::min(2u, std::thread::hardware_concurrency() / 4));
+        for (unsigned n = 0; n < count; ++n) {
+            executors_.push_back(std::make_unique<executor>(L"image encode " + std::to_wstring(n)));
+        }
+    }
 
-    image_consumer(const std::wstring& filename)
-        : filename_(filename)
+    bool try_encode(core::const_frame frame, std::wstring filename, snapshot_options options)
+    {
+        if (++pending_ > capacity_) {
+            --pending_;
+            std::lock_guard<std::mutex> lock(mutex_);
+            deferred_ += 1;
+            return false;
+        }
+
+        auto& executor =
+            **std::min_element(executors_.begin(), executors_.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs->size() < rhs->size();
+            });
+
+        executor.begin_invoke([=] {
+            timer encode_timer;
+            bool  ok = false;
+            try {
+                encode(frame, filename, options);
+                ok = true;
+            } catch (...) {
+                CASPAR_LOG_CURRENT_EXCEPTION();
+            }
+            auto elapsed = encode_timer.elapsed();
+            --pending_;
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (ok) {
+                    encoded_ += 1;
+                    last_encode_time_ = elapsed;
+                    max_encode_time_  = std::max(max_encode_time_, elapsed);
+                } else {
+                    failed_ += 1;
+                }
+            }
+
+            if (ok) {
+                CASPAR_LOG(info) << L"image[] Saved " << filename << L" in " << static_cast<int>(elapsed * 1000.0)
+                                 << L" ms";
+            }
+        });
+
+        return true;
+    }
+
+    core::monitor::state state() const
     {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        core::monitor::state state;
+        state["pending"]          = pending_.load();
+        state["capacity"]         = capacity_;
+        state["encoded"]          = encoded_;
+        state["failed"]           = failed_;
+        state["deferred"]         = deferred_;
+        state["encode-time/last"] = last_encode_time_;
+        state["encode-time/max"]  = max_encode_time_;
+        return state;
     }
 
-    void initialize(const core::video_format_desc&, int) override {}
+    static snapshot_encoder& instance()
+    {
+        static snapshot_encoder encoder;
+        return encoder;
+    }
 
-    std::future<bool> send(core::const_frame frame) override
+  private:
+    static void encode(const core::const_frame& frame, const std::wstring& filename, const snapshot_options& options)
     {
-        auto filename = filename_;
+        auto width  = static_cast<int>(frame.width());
+        auto height = static_cast<int>(frame.height());
+        auto data   = frame.image_data(0).begin();
 
-        std::thread async([frame, filename] {
-            try {
-                auto filename2 = filename;
+        if (options.format == snapshot_format::raw && options.width == 0 && options.height == 0) {
+            std::ofstream file(u8(filename), std::ios::binary);
+            file.write(reinterpret_cast<const char*>(data), frame.image_data(0).size());
+            if (!file)
+                CASPAR_THROW_EXCEPTION(file_write_error() << msg_info("Failed to write " + u8(filename)));
+            return;
+        }
+
+        auto bitmap = std::shared_ptr<FIBITMAP>(FreeImage_Allocate(width, height, 32), FreeImage_Unload);
+        if (!bitmap)
+            CASPAR_THROW_EXCEPTION(bad_alloc());
+
+        auto scale = options.width > 0 || options.height > 0;
 
-                if (filename2.empty())
-                    filename2 = env::media_folder() +
-                                boost::posix_time::to_iso_wstring(boost::posix_time::second_clock::local_time()) +
-                                L".png";
-                else
-                    filename2 = env::media_folder() + filename2 + L".png";
+        // FreeImage stores the image bottom-up. PNG wants straight alpha, but scaling has to be
+        // done premultiplied. JPEG drops alpha which, premultiplied, is the image over black.
+        tbb::parallel_for(0, height, [&](int y) {
+            auto src = data + static_cast<std::size_t>(height - y - 1) * width * 4;
+            auto dst = FreeImage_GetScanLine(bitmap.get(), y);
+            if (options.format == snapshot_format::png && !scale) {
+                unmultiply_row(src, dst, width);
+            } else {
+                std::memcpy(dst, src, static_cast<std::size_t>(width) * 4);
+            }
+        });
+
+        if (scale) {
+            auto dst_width  = options.width > 0 ? options.width : std::max(1, width * options.height / height);
+            auto dst_height = options.height > 0 ? options.height : std::max(1, height * options.width / width);
+
+            bitmap = std::shared_ptr<FIBITMAP>(FreeImage_Rescale(bitmap.get(), dst_width, dst_height, FILTER_BOX),
+                                               FreeImage_Unload);
+            if (!bitmap)
+                CASPAR_THROW_EXCEPTION(bad_alloc());
+
+            width  = dst_width;
+            height = dst_height;
+
+            if (options.format == snapshot_format::png) {
+                tbb::parallel_for(0, height, [&](int y) {
+                    auto row = FreeImage_GetScanLine(bitmap.get(), y);
+                    unmultiply_row(row, row, width);
+                });
+            }
+        }
+
+        if (options.format == snapshot_format::raw) {
+            std::ofstream file(u8(filename), std::ios::binary);
+            for (int y = height - 1; y >= 0; --y) {
+                file.write(reinterpret_cast<const char*>(FreeImage_GetScanLine(bitmap.get(), y)), width * 4);
+            }
+            if (!file)
+                CASPAR_THROW_EXCEPTION(file_write_error() << msg_info("Failed to write " + u8(filename)));
+            return;
+        }
 
-                auto bitmap = std::shared_ptr<FIBITMAP>(
-                    FreeImage_Allocate(static_cast<int>(frame.width()), static_cast<int>(frame.height()), 32),
-                    FreeImage_Unload);
-                std::memcpy(FreeImage_GetBits(bitmap.get()), frame.image_data(0).begin(), frame.image_data(0).size());
+        auto fif   = FIF_PNG;
+        auto flags = options.quality > 0 ? std::min(options.quality, PNG_Z_BEST_COMPRESSION) : PNG_Z_BEST_SPEED;
 
-                image_view<bgra_pixel> original_view(
-                    FreeImage_GetBits(bitmap.get()), static_cast<int>(frame.width()), static_cast<int>(frame.height()));
-                unmultiply(original_view);
+        if (options.format == snapshot_format::jpeg) {
+            bitmap = std::shared_ptr<FIBITMAP>(FreeImage_ConvertTo24Bits(bitmap.get()), FreeImage_Unload);
+            if (!bitmap)
+                CASPAR_THROW_EXCEPTION(bad_alloc());
+
+            fif   = FIF_JPEG;
+            flags = options.quality > 0 ? std::min(options.quality, 100) : 90;
+        }
 
-                FreeImage_FlipVertical(bitmap.get());
 #ifdef WIN32
-                FreeImage_SaveU(FIF_PNG, bitmap.get(), filename2.c_str(), 0);
+        auto saved = FreeImage_SaveU(fif, bitmap.get(), filename.c_str(), flags);
 #else
-                FreeImage_Save(FIF_PNG, bitmap.get(), u8(filename2).c_str(), 0);
+        auto saved = FreeImage_Save(fif, bitmap.get(), u8(filename).c_str(), flags);
 #endif
-            } catch (...) {
-                CASPAR_LOG_CURRENT_EXCEPTION();
+        if (!saved)
+            CASPAR_THROW_EXCEPTION(file_write_error() << msg_info("Failed to save " + u8(filename)));
+    }
+};
+
+core::monitor::state snapshot_state() { return snapshot_encoder::instance().state(); }
+
+struct image_consumer : public core::frame_consumer
+{
+    const std::wstring     filename_;
+    const snapshot_options options_;
+    bool                   deferred_ = false;
+
+  public:
+    // frame_consumer
+
+    image_consumer(const std::wstring& filename, const snapshot_options& options)
+        : filename_(filename)
+        , options_(options)
+    {
+    }
+
+    void initialize(const core::video_format_desc&, int) override {}
+
+    std::future<bool> send(core::const_frame frame) override
+    {
+        static const std::wstring extensions[] = {L".png", L".jpg", L".bgra"};
+
+        auto filename = env::media_folder() +
+                        (filename_.empty()
+                             ? boost::posix_time::to_iso_wstring(boost::posix_time::second_clock::local_time())
+                             : filename_) +
+                        extensions[static_cast<int>(options_.format)];
+
+        // Never block the channel. While the encoder is busy the snapshot is taken from a later frame.
+        if (!snapshot_encoder::instance().try_encode(std::move(frame), std::move(filename), options_)) {
+            if (!deferred_) {
+                CASPAR_LOG(warning) << print() << L" Encoder busy, deferring snapshot.";
+                deferred_ = true;
             }
-        });
-        async.detach();
+            return make_ready_future(true);
+        }
 
         return make_ready_future(false);
     }
@@ -120,10 +310,25 @@ spl::shared_ptr<core::frame_consumer> create_consumer(const std::vector<std::wst
 
     std::wstring filename;
 
-    if (params.size() > 1)
+    if (params.size() > 1 && !boost::iequals(params.at(1), L"FORMAT") && !boost::iequals(params.at(1), L"QUALITY") &&
+        !boost::iequals(params.at(1), L"WIDTH") && !boost::iequals(params.at(1), L"HEIGHT"))
         filename = params.at(1);
 
-    return spl::make_shared<image_consumer>(filename);
+    snapshot_options options;
+
+    auto format = get_param(L"FORMAT", params, L"PNG");
+    if (boost::iequals(format, L"JPEG") || boost::iequals(format, L"JPG"))
+        options.format = snapshot_format::jpeg;
+    else if (boost::iequals(format, L"RAW") || boost::iequals(format, L"BGRA"))
+        options.format = snapshot_format::raw;
+    else if (!boost::iequals(format, L"PNG"))
+        CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Unsupported snapshot format " + format));
+
+    options.quality = get_param(L"QUALITY", params, 0);
+    options.width   = std::max(0, get_param(L"WIDTH", params, 0));
+    options.height  = std::max(0, get_param(L"HEIGHT", params, 0));
+
+    return spl::make_shared<image_consumer>(filename, options);
 }
 
 }} // namespace caspar::image
@@ -26,6 +26,7 @@
 #include <boost/filesystem.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <core/consumer/frame_consumer.h>
+#include <core/monitor/monitor.h>
 #include <core/video_format.h>
 
 #include <string>
@@ -36,4 +37,6 @@ namespace caspar { namespace image {
 spl::shared_ptr<core::frame_consumer> create_consumer(const std::vector<std::wstring>&                  params,
                                                       std::vector<spl::shared_ptr<core::video_channel>> channels);
 
+core::monitor::state snapshot_state();
+
 }} // namespace caspar::image
@@ -29,10 +29,12 @@
 
 #include "consumer/image_consumer.h"
 #include "producer/image_producer.h"
+#include "util/image_cache.h"
 #include "util/image_loader.h"
 
 #include <core/consumer/frame_consumer.h>
 #include <core/frame/draw_frame.h>
+#include <core/monitor/system_state.h>
 #include <core/producer/frame_producer.h>
 
 #include <common/utf.h>
@@ -49,8 +51,19 @@ void init(core::module_dependencies dependencies)
     FreeImage_Initialise();
     dependencies.producer_registry->register_producer_factory(L"Image Producer", create_producer);
     dependencies.consumer_registry->register_consumer_factory(L"Image Consumer", create_consumer);
+    core::monitor::register_system_state("image", [] {
+        core::monitor::state state;
+        state["cache"]    = image_cache::instance().state();
+        state["snapshot"] = snapshot_state();
+        return state;
+    });
 }
 
-void uninit() { FreeImage_DeInitialise(); }
+void uninit()
+{
+    // Cached frames may hold textures which must be released before the accelerator.
+    image_cache::instance().clear();
+    FreeImage_DeInitialise();
+}
 
 }} // namespace caspar::image
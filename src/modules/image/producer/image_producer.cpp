@@ -21,13 +21,9 @@
 
 #include "image_producer.h"
 
-#define WIN32_LEAN_AND_MEAN
-#define NOMINMAX
-#if defined(_MSC_VER)
-#include <windows.h>
-#endif
-#include <FreeImage.h>
+#include "image_sequence_producer.h"
 
+#include "../util/image_cache.h"
 #include "../util/image_loader.h"
 
 #include <core/video_format.h>
@@ -51,6 +47,7 @@
 #include <boost/property_tree/ptree.hpp>
 
 #include <algorithm>
+#include <future>
 #include <set>
 
 namespace caspar { namespace image {
@@ -65,12 +62,33 @@ struct image_producer : public core::frame_producer
 
     image_producer(const spl::shared_ptr<core::frame_factory>& frame_factory,
                    const std::wstring&                         description,
-                   uint32_t                                    length)
+                   uint32_t                                    length,
+                   int                                         min_width,
+                   int                                         min_height)
         : description_(description)
         , frame_factory_(frame_factory)
         , length_(length)
     {
-        load(load_image(description_));
+        // Stills larger than the channel are only ever shown scaled down, so don't keep them in full size.
+        if (!env::properties().get(L"configuration.image.downscale", true)) {
+            min_width  = 0;
+            min_height = 0;
+        }
+
+        auto format = min_width > 0 && min_height > 0
+                          ? L"bgra/" + std::to_wstring(min_width) + L"x" + std::to_wstring(min_height)
+                          : std::wstring(L"bgra");
+
+        // Decoded on the pool, which bounds concurrent decodes, but waited for so that the first frame is there for
+        // transitions and errors reach the caller.
+        frame_ = core::draw_frame(decode_executor()
+                                      .begin_invoke([=, tag = static_cast<const void*>(this)] {
+                                          return image_cache::instance().get(description, format, [&] {
+                                              return create_frame(
+                                                  frame_factory, tag, load_image(description, min_width, min_height));
+                                          });
+                                      })
+                                      .get());
 
         CASPAR_LOG(info) << print() << L" Initialized";
     }
@@ -83,24 +101,11 @@ struct image_producer : public core::frame_producer
         , frame_factory_(frame_factory)
         , length_(length)
     {
-        load(load_png_from_memory(png_data, size));
+        frame_ = core::draw_frame(create_frame(frame_factory_, this, load_png_from_memory(png_data, size)));
 
         CASPAR_LOG(info) << print() << L" Initialized";
     }
 
-    void load(const std::shared_ptr<FIBITMAP>& bitmap)
-    {
-        FreeImage_FlipVertical(bitmap.get());
-        core::pixel_format_desc desc;
-        desc.format = core::pixel_format::bgra;
-        desc.planes.push_back(
-            core::pixel_format_desc::plane(FreeImage_GetWidth(bitmap.get()), FreeImage_GetHeight(bitmap.get()), 4));
-        auto frame = frame_factory_->create_frame(this, desc);
-
-        std::copy_n(FreeImage_GetBits(bitmap.get()), frame.image_data(0).size(), frame.image_data(0).begin());
-        frame_ = core::draw_frame(std::move(frame));
-    }
-
     // frame_producer
 
     core::draw_frame last_frame() override { return frame_; }
@@ -140,55 +145,10 @@ spl::shared_ptr<core::frame_producer> create_producer(const core::frame_producer
 {
     auto length = get_param(L"LENGTH", params, std::numeric_limits<uint32_t>::max());
 
-    // if (boost::iequals(params.at(0), L"[IMG_SEQUENCE]"))
-    //{
-    //	if (params.size() != 2)
-    //		return core::frame_producer::empty();
-
-    //	auto dir = boost::filesystem::path(env::media_folder() + params.at(1)).parent_path();
-    //	auto basename = boost::filesystem::basename(params.at(1));
-    //	std::set<std::wstring> files;
-    //	boost::filesystem::directory_iterator end;
-
-    //	for (boost::filesystem::directory_iterator it(dir); it != end; ++it)
-    //	{
-    //		auto name = it->path().filename().wstring();
-
-    //		if (!boost::algorithm::istarts_with(name, basename))
-    //			continue;
-
-    //		auto extension = it->path().extension().wstring();
-
-    //		if (std::find_if(supported_extensions().begin(), supported_extensions().end(), ieq(extension)) ==
-    // supported_extensions().end()) 			continue;
-
-    //		files.insert(it->path().wstring());
-    //	}
-
-    //	if (files.empty())
-    //		return core::frame_producer::empty();
-
-    //	int width = -1;
-    //	int height = -1;
-    //	std::vector<core::draw_frame> frames;
-    //	frames.reserve(files.size());
-
-    //	for (auto& file : files)
-    //	{
-    //		auto frame = load_image(dependencies.frame_factory, file);
-
-    //		if (width == -1)
-    //		{
-    //			width = static_cast<int>(frame.second.width.get());
-    //			height = static_cast<int>(frame.second.height.get());
-    //		}
-
-    //		frames.push_back(std::move(frame.first));
-    //	}
+    if (boost::iequals(params.at(0), L"[IMG_SEQUENCE]")) {
+        return create_sequence_producer(dependencies, params);
+    }
 
-    //	return core::create_const_producer(std::move(frames), width, height);
-    //}
-    // else
     // if (boost::iequals(params.at(0), L"[PNG_BASE64]")) {
     //    if (params.size() < 2)
     //        return core::frame_producer::empty();
@@ -211,8 +171,11 @@ spl::shared_ptr<core::frame_producer> create_producer(const core::frame_producer
         return core::frame_producer::empty();
     }
 
-    return spl::make_shared<image_producer>(
-        dependencies.frame_factory, *caspar::find_case_insensitive(filename + *ext), length);
+    return spl::make_shared<image_producer>(dependencies.frame_factory,
+                                            *caspar::find_case_insensitive(filename + *ext),
+                                            length,
+                                            dependencies.format_desc.width,
+                                            dependencies.format_desc.height);
 }
 
 }} // namespace caspar::image
@@ -0,0 +1,440 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+
+#include "image_sequence_producer.h"
+
+#include "../util/image_loader.h"
+
+#include <core/frame/draw_frame.h>
+#include <core/frame/frame.h>
+#include <core/frame/frame_factory.h>
+#include <core/monitor/monitor.h>
+#include <core/video_format.h>
+
+#include <common/diagnostics/graph.h>
+#include <common/env.h>
+#include <common/future.h>
+#include <common/log.h>
+#include <common/os/filesystem.h>
+#include <common/param.h>
+#include <common/utf.h>
+
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cwctype>
+#include <future>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+
+namespace caspar { namespace image {
+
+struct image_sequence_producer : public core::frame_producer
+{
+    spl::shared_ptr<diagnostics::graph> graph_;
+
+    const std::wstring                             description_;
+    const std::vector<std::wstring>                files_;
+    const spl::shared_ptr<core::frame_factory>     frame_factory_;
+    const core::video_format_desc                  format_desc_;
+    const uint32_t                                 window_size_;
+    const std::shared_ptr<const std::atomic<bool>> offline_;
+
+    mutable std::mutex mutex_;
+    uint32_t           in_;
+    uint32_t           out_;
+    bool               loop_;
+    uint32_t           time_;
+    uint32_t           frame_time_ = 0;
+    core::draw_frame   frame_;
+    uint64_t           underflows_ = 0;
+    const bool         downscale_;
+
+    std::map<uint32_t, std::shared_future<core::const_frame>> window_;
+
+    // Pending decodes of a window which has been discarded (seek, destruction) are skipped.
+    std::shared_ptr<void> token_ = std::make_shared<int>(0);
+
+    image_sequence_producer(const spl::shared_ptr<core::frame_factory>& frame_factory,
+                            const core::video_format_desc&              format_desc,
+                            const std::wstring&                         description,
+                            std::vector<std::wstring>                   files,
+                            uint32_t                                    in,
+                            uint32_t                                    out,
+                            bool                                        loop,
+                            std::shared_ptr<const std::atomic<bool>>    offline)
+        : description_(description)
+        , files_(std::move(files))
+        , frame_factory_(frame_factory)
+        , format_desc_(format_desc)
+        , window_size_(std::max(2u, env::properties().get(L"configuration.image.sequence-prefetch", 8u)))
+        , offline_(std::move(offline))
+        , in_(std::min(in, static_cast<uint32_t>(files_.size() - 1)))
+        , out_(std::max(in_ + 1, std::min(out, static_cast<uint32_t>(files_.size()))))
+        , loop_(loop)
+        , time_(in_)
+        , downscale_(env::properties().get(L"configuration.image.downscale", true))
+    {
+        diagnostics::register_graph(graph_);
+        graph_->set_color("underflow", diagnostics::color(0.6f, 0.3f, 0.9f));
+        graph_->set_color("offline-timeout", diagnostics::color(1.0f, 0.3f, 0.3f));
+        graph_->set_color("buffer", diagnostics::color(1.0f, 1.0f, 0.0f));
+        graph_->set_text(print());
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        prefetch();
+
+        CASPAR_LOG(info) << print() << L" Initialized";
+    }
+
+    ~image_sequence_producer() { token_.reset(); }
+
+    // Called with mutex_ held. Keeps decodes in flight for the next window_size_
+    // frames, following out and loop, and drops everything else.
+    void prefetch()
+    {
+        std::set<uint32_t> wanted;
+
+        auto time = time_;
+        for (uint32_t n = 0; n < window_size_; ++n) {
+            if (time >= out_) {
+                if (!loop_) {
+                    break;
+                }
+                time = in_;
+            }
+            if (!wanted.insert(time).second) {
+                break;
+            }
+            time += 1;
+        }
+
+        for (auto it = window_.begin(); it != window_.end();) {
+            it = wanted.count(it->first) ? std::next(it) : window_.erase(it);
+        }
+
+        auto token      = std::weak_ptr<void>(token_);
+        auto factory    = frame_factory_;
+        auto tag        = static_cast<const void*>(this);
+        auto min_width  = downscale_ ? format_desc_.width : 0;
+        auto min_height = downscale_ ? format_desc_.height : 0;
+
+        for (auto time : wanted) {
+            if (window_.count(time)) {
+                continue;
+            }
+            auto filename = files_[time];
+
+            window_[time] = decode_executor()
+                                .begin_invoke([=]() -> core::const_frame {
+                                    if (token.expired()) {
+                                        return core::const_frame{};
+                                    }
+                                    return create_frame(factory, tag, load_image(filename, min_width, min_height));
+                                })
+                                .share();
+        }
+
+        auto ready = std::count_if(window_.begin(), window_.end(), [](auto& p) { return is_ready(p.second); });
+        graph_->set_value("buffer", static_cast<double>(ready) / static_cast<double>(window_size_));
+    }
+
+    // frame_producer
+
+    core::draw_frame receive_impl(int nb_samples) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (time_ >= out_) {
+            if (!loop_) {
+                return core::draw_frame::still(frame_);
+            }
+            time_ = in_;
+        }
+
+        auto it = window_.find(time_);
+
+        // An offline channel waits for the decode rather than repeat a frame. The wait is bounded so that a stuck
+        // decode cannot stall the channel.
+        if (*offline_ && (it == window_.end() || !is_ready(it->second))) {
+            if (it == window_.end()) {
+                prefetch();
+                it = window_.find(time_);
+            }
+            if (it != window_.end() && it->second.wait_for(std::chrono::seconds(10)) != std::future_status::ready) {
+                graph_->set_tag(diagnostics::tag_severity::WARNING, "offline-timeout");
+                CASPAR_LOG(warning) << print() << L" Image was not decoded within 10 s, repeating a frame.";
+            }
+        }
+
+        if (it == window_.end() || !is_ready(it->second)) {
+            graph_->set_tag(diagnostics::tag_severity::WARNING, "underflow");
+            underflows_ += 1;
+            prefetch();
+            return core::draw_frame{};
+        }
+
+        try {
+            frame_ = core::draw_frame(it->second.get());
+        } catch (...) {
+            CASPAR_LOG_CURRENT_EXCEPTION();
+            CASPAR_LOG(warning) << print() << L" Skipping " << files_[time_];
+        }
+        window_.erase(it);
+
+        frame_time_ = time_;
+        time_ += 1;
+
+        prefetch();
+        graph_->set_text(print());
+
+        return frame_;
+    }
+
+    core::draw_frame last_frame() override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        if (!frame_) {
+            auto it = window_.find(time_);
+            if (it != window_.end() && is_ready(it->second)) {
+                try {
+                    return core::draw_frame::still(core::draw_frame(it->second.get()));
+                } catch (...) {
+                }
+            }
+        }
+
+        return core::draw_frame::still(frame_);
+    }
+
+    uint32_t frame_number() const override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return frame_time_ > in_ ? frame_time_ - in_ : 0;
+    }
+
+    uint32_t nb_frames() const override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return loop_ ? std::numeric_limits<uint32_t>::max() : out_ - in_;
+    }
+
+    std::future<std::wstring> call(const std::vector<std::wstring>& params) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        std::wstring result;
+
+        std::wstring cmd = params.at(0);
+        std::wstring value;
+        if (params.size() > 1) {
+            value = params.at(1);
+        }
+
+        auto nb_files = static_cast<int64_t>(files_.size());
+        auto clamp    = [&](int64_t time) {
+            return static_cast<uint32_t>(std::max<int64_t>(0, std::min(time, nb_files)));
+        };
+
+        if (boost::iequals(cmd, L"loop")) {
+            if (!value.empty()) {
+                loop_ = boost::lexical_cast<bool>(value);
+            }
+
+            result = boost::lexical_cast<std::wstring>(loop_);
+        } else if (boost::iequals(cmd, L"in") || boost::iequals(cmd, L"start")) {
+            if (!value.empty()) {
+                in_  = std::min(clamp(boost::lexical_cast<int64_t>(value)), static_cast<uint32_t>(nb_files - 1));
+                out_ = std::max(out_, in_ + 1);
+            }
+
+            result = boost::lexical_cast<std::wstring>(in_);
+        } else if (boost::iequals(cmd, L"out")) {
+            if (!value.empty()) {
+                out_ = std::max(in_ + 1, clamp(boost::lexical_cast<int64_t>(value)));
+            }
+
+            result = boost::lexical_cast<std::wstring>(out_);
+        } else if (boost::iequals(cmd, L"length")) {
+            if (!value.empty()) {
+                out_ = std::max(in_ + 1, clamp(in_ + boost::lexical_cast<int64_t>(value)));
+            }
+
+            result = boost::lexical_cast<std::wstring>(out_ - in_);
+        } else if (boost::iequals(cmd, L"seek") && !value.empty()) {
+            int64_t seek;
+            if (boost::iequals(value, L"rel")) {
+                seek = frame_time_;
+            } else if (boost::iequals(value, L"in")) {
+                seek = in_;
+            } else if (boost::iequals(value, L"out")) {
+                seek = out_;
+            } else if (boost::iequals(value, L"end")) {
+                seek = nb_files;
+            } else {
+                seek = boost::lexical_cast<int64_t>(value);
+            }
+
+            if (params.size() > 2) {
+                seek += boost::lexical_cast<int64_t>(params.at(2));
+            }
+
+            time_ = std::min(clamp(seek), static_cast<uint32_t>(nb_files - 1));
+
+            // Decodes queued for the old position are of no use anymore.
+            token_ = std::make_shared<int>(0);
+            window_.clear();
+
+            result = boost::lexical_cast<std::wstring>(time_);
+        } else {
+            CASPAR_THROW_EXCEPTION(invalid_argument());
+        }
+
+        prefetch();
+        graph_->set_text(print());
+
+        return make_ready_future(std::move(result));
+    }
+
+    core::monitor::state state() const override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        core::monitor::state state;
+        state["file/path"]           = description_;
+        state["file/time"]           = {frame_time_ / format_desc_.fps, files_.size() / format_desc_.fps};
+        state["file/clip"]           = {in_ / format_desc_.fps, (out_ - in_) / format_desc_.fps};
+        state["loop"]                = loop_;
+        state["sequence/frames"]     = static_cast<int>(files_.size());
+        state["sequence/buffer"]     = static_cast<int>(window_.size());
+        state["sequence/underflows"] = static_cast<int64_t>(underflows_);
+        return state;
+    }
+
+    std::wstring print() const override
+    {
+        return L"image_sequence[" + description_ + L"|" + boost::lexical_cast<std::wstring>(frame_time_) + L"/" +
+               boost::lexical_cast<std::wstring>(files_.size()) + L"]";
+    }
+
+    std::wstring name() const override { return L"image_sequence"; }
+};
+
+// Frame number following the basename, e.g. "name_00042.png" => 42.
+int64_t sequence_number(const std::wstring& stem, std::size_t basename_size)
+{
+    auto begin =
+        std::find_if(stem.begin() + basename_size, stem.end(), [](wchar_t c) { return std::iswdigit(c) != 0; });
+    auto end = std::find_if(begin, stem.end(), [](wchar_t c) { return std::iswdigit(c) == 0; });
+
+    if (begin == end || end - begin > 18) {
+        return -1;
+    }
+
+    return boost::lexical_cast<int64_t>(std::wstring(begin, end));
+}
+
+std::vector<std::wstring> index_sequence(const std::wstring& path)
+{
+    auto basename = boost::filesystem::path(path).filename().wstring();
+    auto dir      = find_case_insensitive(boost::filesystem::path(path).parent_path().wstring());
+
+    if (!dir || basename.empty() || !boost::filesystem::is_directory(*dir)) {
+        return {};
+    }
+
+    std::vector<std::pair<std::pair<int64_t, std::wstring>, std::wstring>> entries;
+
+    for (auto it = boost::filesystem::directory_iterator(*dir); it != boost::filesystem::directory_iterator(); ++it) {
+        auto name = it->path().filename().wstring();
+
+        if (!boost::algorithm::istarts_with(name, basename)) {
+            continue;
+        }
+
+        auto extension = it->path().extension().wstring();
+
+        if (std::none_of(supported_extensions().begin(), supported_extensions().end(), [&](const std::wstring& ex) {
+                return boost::iequals(ex, extension);
+            })) {
+            continue;
+        }
+
+        auto stem = it->path().stem().wstring();
+        entries.emplace_back(std::make_pair(sequence_number(stem, basename.size()), name), it->path().wstring());
+    }
+
+    std::sort(entries.begin(), entries.end());
+
+    std::vector<std::wstring> files;
+    files.reserve(entries.size());
+    for (auto& entry : entries) {
+        files.push_back(std::move(entry.second));
+    }
+    return files;
+}
+
+spl::shared_ptr<core::frame_producer>
+create_sequence_producer(const core::frame_producer_dependencies& dependencies,
+                         const std::vector<std::wstring>&         params)
+{
+    if (params.size() < 2) {
+        return core::frame_producer::empty();
+    }
+
+    auto files = index_sequence(env::media_folder() + params.at(1));
+
+    if (files.empty()) {
+        return core::frame_producer::empty();
+    }
+
+    auto loop = contains_param(L"LOOP", params);
+
+    auto in = get_param(L"SEEK", params, static_cast<uint32_t>(0)); // compatibility
+    in      = get_param(L"IN", params, in);
+
+    auto out = get_param(L"LENGTH", params, std::numeric_limits<uint32_t>::max());
+    if (out < std::numeric_limits<uint32_t>::max() - in)
+        out += in;
+    else
+        out = std::numeric_limits<uint32_t>::max();
+    out = get_param(L"OUT", params, out);
+
+    return core::create_destroy_proxy(spl::make_shared<image_sequence_producer>(dependencies.frame_factory,
+                                                                                dependencies.format_desc,
+                                                                                params.at(1),
+                                                                                std::move(files),
+                                                                                in,
+                                                                                out,
+                                                                                loop,
+                                                                                dependencies.offline));
+}
+
+}} // namespace caspar::image
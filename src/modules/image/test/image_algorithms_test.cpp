@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Checks premultiply_row() and unmultiply_row() against the scalar premultiply()
+// and unmultiply() for every (channel, alpha) pair and reports their throughput.
+// Pass "--bench-only" to skip the correctness check.
+
+#include "../util/image_algorithms.h"
+#include "../util/image_view.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+using namespace caspar::image;
+
+namespace {
+
+typedef void (*row_func)(const uint8_t* src, uint8_t* dst, int width);
+
+// One pixel per (channel, alpha) pair, with the channel spread differently over b, g and r.
+std::vector<uint8_t> all_pairs()
+{
+    std::vector<uint8_t> pixels;
+    pixels.reserve(256 * 256 * 4);
+
+    for (int alpha = 0; alpha < 256; ++alpha) {
+        for (int c = 0; c < 256; ++c) {
+            pixels.push_back(static_cast<uint8_t>(c));
+            pixels.push_back(static_cast<uint8_t>(255 - c));
+            pixels.push_back(static_cast<uint8_t>(c ^ 0x5A));
+            pixels.push_back(static_cast<uint8_t>(alpha));
+        }
+    }
+    return pixels;
+}
+
+template <class Reference>
+int check(const char* name, row_func kernel, Reference reference)
+{
+    const auto src   = all_pairs();
+    auto       ref   = src;
+    auto       count = static_cast<int>(src.size() / 4);
+
+    image_view<bgra_pixel> view(ref.data(), count, 1);
+    reference(view);
+
+    int failures = 0;
+
+    // Odd offsets and widths run every SIMD width as well as the scalar tail.
+    for (int width : {1, 3, 4, 7, 8, 15, 16, 17, 31, 33}) {
+        for (int offset = 0; offset < count; offset += width) {
+            auto n = std::min(width, count - offset);
+
+            std::vector<uint8_t> dst(n * 4);
+            kernel(src.data() + offset * 4, dst.data(), n);
+
+            std::vector<uint8_t> in_place(src.begin() + offset * 4, src.begin() + (offset + n) * 4);
+            kernel(in_place.data(), in_place.data(), n);
+
+            for (int i = 0; i < n * 4; ++i) {
+                auto expected = ref[offset * 4 + i];
+                if ((dst[i] != expected || in_place[i] != expected) && failures++ < 16) {
+                    std::printf("%s: channel %d alpha %d: expected %d, got %d (in place %d)\n",
+                                name,
+                                src[offset * 4 + i],
+                                src[(offset * 4 + i) | 3],
+                                expected,
+                                dst[i],
+                                in_place[i]);
+                }
+            }
+        }
+    }
+
+    std::printf("%s: %s\n", name, failures == 0 ? "ok" : "FAILED");
+    return failures;
+}
+
+double megapixels_per_second(const std::function<void(uint8_t*)>& func, std::vector<uint8_t>& image, int pixels)
+{
+    const int iterations = 50;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < iterations; ++n) {
+        func(image.data());
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    return static_cast<double>(pixels) * iterations / elapsed / 1000000.0;
+}
+
+void bench(const char* name, row_func kernel, const std::function<void(image_view<bgra_pixel>&)>& reference)
+{
+    const int width  = 1920;
+    const int height = 1080;
+
+    auto                 pairs = all_pairs();
+    std::vector<uint8_t> image(width * height * 4);
+    for (std::size_t n = 0; n < image.size(); ++n) {
+        image[n] = pairs[n % pairs.size()];
+    }
+    auto copy = image;
+
+    auto scalar = megapixels_per_second(
+        [&](uint8_t* data) {
+            std::memcpy(data, copy.data(), copy.size());
+            image_view<bgra_pixel> view(data, width, height);
+            reference(view);
+        },
+        image,
+        width * height);
+
+    auto simd = megapixels_per_second(
+        [&](uint8_t* data) {
+            std::memcpy(data, copy.data(), copy.size());
+            for (int y = 0; y < height; ++y) {
+                kernel(data + y * width * 4, data + y * width * 4, width);
+            }
+        },
+        image,
+        width * height);
+
+    std::printf("%s: scalar %.0f Mpx/s, row %.0f Mpx/s (%.1fx, including a frame copy)\n",
+                name,
+                scalar,
+                simd,
+                simd / scalar);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    auto bench_only = argc > 1 && std::strcmp(argv[1], "--bench-only") == 0;
+
+    int failures = 0;
+    if (!bench_only) {
+        failures += check("premultiply", premultiply_row, [](image_view<bgra_pixel>& v) { premultiply(v); });
+        failures += check("unmultiply", unmultiply_row, [](image_view<bgra_pixel>& v) { unmultiply(v); });
+    }
+
+    bench("premultiply", premultiply_row, [](image_view<bgra_pixel>& v) { premultiply(v); });
+    bench("unmultiply", unmultiply_row, [](image_view<bgra_pixel>& v) { unmultiply(v); });
+
+    return failures == 0 ? 0 : 1;
+}
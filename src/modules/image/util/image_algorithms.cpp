@@ -21,7 +21,14 @@
 
 #include "image_algorithms.h"
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -46,4 +53,135 @@ std::vector<std::pair<int, int>> get_line_points(int num_pixels, double angle_ra
     return std::move(line_points);
 }
 
+namespace {
+
+// round(c * a / 255) for c, a in [0, 255], exact in 16 bits.
+inline int mul_div_255(int c, int a)
+{
+    int t = c * a + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+void premultiply_pixels(const uint8_t* src, uint8_t* dst, int count)
+{
+    for (int n = 0; n < count; ++n, src += 4, dst += 4) {
+        int alpha = src[3];
+        dst[0]    = static_cast<uint8_t>(mul_div_255(src[0], alpha));
+        dst[1]    = static_cast<uint8_t>(mul_div_255(src[1], alpha));
+        dst[2]    = static_cast<uint8_t>(mul_div_255(src[2], alpha));
+        dst[3]    = static_cast<uint8_t>(alpha);
+    }
+}
+
+void unmultiply_pixels(const uint8_t* src, uint8_t* dst, int count)
+{
+    for (int n = 0; n < count; ++n, src += 4, dst += 4) {
+        int alpha = src[3];
+        if (alpha == 0) {
+            std::copy_n(src, 4, dst);
+            continue;
+        }
+        dst[0] = static_cast<uint8_t>(std::min(255, (src[0] * 255 + alpha / 2) / alpha));
+        dst[1] = static_cast<uint8_t>(std::min(255, (src[1] * 255 + alpha / 2) / alpha));
+        dst[2] = static_cast<uint8_t>(std::min(255, (src[2] * 255 + alpha / 2) / alpha));
+        dst[3] = static_cast<uint8_t>(alpha);
+    }
+}
+
+// Eight pixels widened to 16 bits: each alpha is copied to its color lanes and
+// the alpha lanes are multiplied by 255 so they come out unchanged.
+inline __m128i premultiply_epi16(__m128i px)
+{
+    const __m128i alpha_mask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+    const __m128i alpha_255  = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+
+    auto alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    alpha      = _mm_or_si128(_mm_andnot_si128(alpha_mask, alpha), alpha_255);
+
+    auto t = _mm_add_epi16(_mm_mullo_epi16(px, alpha), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+#ifdef __AVX2__
+inline __m256i premultiply_epi16(__m256i px)
+{
+    const __m256i alpha_mask = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0);
+    const __m256i alpha_255  = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+
+    auto alpha =
+        _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(px, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    alpha = _mm256_or_si256(_mm256_andnot_si256(alpha_mask, alpha), alpha_255);
+
+    auto t = _mm256_add_epi16(_mm256_mullo_epi16(px, alpha), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+#endif
+
+// One pixel widened to 32 bits. The quotient is exact in single precision:
+// the numerator fits in 24 bits and a non-integer quotient is at least 1/255
+// away from the next integer, so truncation matches the integer division.
+inline __m128i unmultiply_epi32(__m128i px)
+{
+    auto alpha = _mm_shuffle_epi32(px, _MM_SHUFFLE(3, 3, 3, 3));
+    auto num   = _mm_add_epi32(_mm_sub_epi32(_mm_slli_epi32(px, 8), px), _mm_srli_epi32(alpha, 1));
+    return _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(num), _mm_cvtepi32_ps(alpha)));
+}
+
+} // namespace
+
+void premultiply_row(const uint8_t* src, uint8_t* dst, int width)
+{
+    int n = 0;
+
+#ifdef __AVX2__
+    for (; n + 8 <= width; n += 8) {
+        auto px   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + n * 4));
+        auto zero = _mm256_setzero_si256();
+        auto lo   = premultiply_epi16(_mm256_unpacklo_epi8(px, zero));
+        auto hi   = premultiply_epi16(_mm256_unpackhi_epi8(px, zero));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + n * 4), _mm256_packus_epi16(lo, hi));
+    }
+#endif
+
+    for (; n + 4 <= width; n += 4) {
+        auto px   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n * 4));
+        auto zero = _mm_setzero_si128();
+        auto lo   = premultiply_epi16(_mm_unpacklo_epi8(px, zero));
+        auto hi   = premultiply_epi16(_mm_unpackhi_epi8(px, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + n * 4), _mm_packus_epi16(lo, hi));
+    }
+
+    premultiply_pixels(src + n * 4, dst + n * 4, width - n);
+}
+
+void unmultiply_row(const uint8_t* src, uint8_t* dst, int width)
+{
+    const __m128i alpha_mask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+    int n = 0;
+
+    for (; n + 4 <= width; n += 4) {
+        auto px   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + n * 4));
+        auto zero = _mm_setzero_si128();
+        auto lo   = _mm_unpacklo_epi8(px, zero);
+        auto hi   = _mm_unpackhi_epi8(px, zero);
+
+        // Quotients above 255 saturate in the packs.
+        auto lo32 = _mm_packs_epi32(unmultiply_epi32(_mm_unpacklo_epi16(lo, zero)),
+                                    unmultiply_epi32(_mm_unpackhi_epi16(lo, zero)));
+        auto hi32 = _mm_packs_epi32(unmultiply_epi32(_mm_unpacklo_epi16(hi, zero)),
+                                    unmultiply_epi32(_mm_unpackhi_epi16(hi, zero)));
+        auto res  = _mm_packus_epi16(lo32, hi32);
+
+        // Keep alpha as is, and pixels with zero alpha untouched.
+        auto transparent = _mm_cmpeq_epi32(_mm_and_si128(px, alpha_mask), zero);
+        res              = _mm_or_si128(_mm_andnot_si128(alpha_mask, res), _mm_and_si128(px, alpha_mask));
+        res              = _mm_or_si128(_mm_and_si128(transparent, px), _mm_andnot_si128(transparent, res));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + n * 4), res);
+    }
+
+    unmultiply_pixels(src + n * 4, dst + n * 4, width - n);
+}
+
 }} // namespace caspar::image
\ No newline at end of file
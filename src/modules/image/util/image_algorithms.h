@@ -171,6 +171,8 @@ void blur(const SrcView& src, DstView& dst, double angle_radians, int blur_px, c
  * Premultiply with alpha for each pixel in an ImageView. The modifications is
  * done in place. The pixel type of the ImageView must model the RGBAPixel
  * concept.
+ * <p>
+ * This is the scalar reference for premultiply_row().
  *
  * @param view_to_modify The image view to premultiply in place. Has to model
  *                       the ImageView concept and have a pixel type that
@@ -186,13 +188,13 @@ void premultiply(SrcDstView& view_to_modify)
         {
             // We don't event try to premultiply 0 since it will be unaffected.
             if (pixel.r())
-                pixel.r() = static_cast<uint8_t>(static_cast<int>(pixel.r()) * alpha / 255);
+                pixel.r() = static_cast<uint8_t>((static_cast<int>(pixel.r()) * alpha + 127) / 255);
 
             if (pixel.g())
-                pixel.g() = static_cast<uint8_t>(static_cast<int>(pixel.g()) * alpha / 255);
+                pixel.g() = static_cast<uint8_t>((static_cast<int>(pixel.g()) * alpha + 127) / 255);
 
             if (pixel.b())
-                pixel.b() = static_cast<uint8_t>(static_cast<int>(pixel.b()) * alpha / 255);
+                pixel.b() = static_cast<uint8_t>((static_cast<int>(pixel.b()) * alpha + 127) / 255);
         }
     });
 }
@@ -201,6 +203,8 @@ void premultiply(SrcDstView& view_to_modify)
  * Un-multiply with alpha for each pixel in an ImageView. The modifications is
  * done in place. The pixel type of the ImageView must model the RGBAPixel
  * concept.
+ * <p>
+ * This is the scalar reference for unmultiply_row().
  *
  * @param view_to_modify The image view to unmultiply in place. Has to model
  *                       the ImageView concept and have a pixel type that
@@ -215,15 +219,39 @@ void unmultiply(SrcDstView& view_to_modify)
         if (alpha != 0 && alpha != 255) {
             // We don't event try to premultiply 0 since it will be unaffected.
             if (pixel.r())
-                pixel.r() = static_cast<uint8_t>(static_cast<int>(pixel.r()) * 255 / alpha);
+                pixel.r() =
+                    static_cast<uint8_t>(std::min(255, (static_cast<int>(pixel.r()) * 255 + alpha / 2) / alpha));
 
             if (pixel.g())
-                pixel.g() = static_cast<uint8_t>(static_cast<int>(pixel.g()) * 255 / alpha);
+                pixel.g() =
+                    static_cast<uint8_t>(std::min(255, (static_cast<int>(pixel.g()) * 255 + alpha / 2) / alpha));
 
             if (pixel.b())
-                pixel.b() = static_cast<uint8_t>(static_cast<int>(pixel.b()) * 255 / alpha);
+                pixel.b() =
+                    static_cast<uint8_t>(std::min(255, (static_cast<int>(pixel.b()) * 255 + alpha / 2) / alpha));
         }
     });
 }
 
+/**
+ * Premultiply a row of BGRA pixels with alpha, rounding to nearest. Uses
+ * SSE2/AVX2 where available and gives the same result as premultiply().
+ *
+ * @param src   The straight alpha source pixels.
+ * @param dst   The destination for the premultiplied pixels. May be src.
+ * @param width The number of pixels in the row.
+ */
+void premultiply_row(const uint8_t* src, uint8_t* dst, int width);
+
+/**
+ * Un-multiply a row of BGRA pixels with alpha, rounding to nearest and
+ * saturating. Uses SSE2/AVX2 where available and gives the same result as
+ * unmultiply().
+ *
+ * @param src   The premultiplied source pixels.
+ * @param dst   The destination for the straight alpha pixels. May be src.
+ * @param width The number of pixels in the row.
+ */
+void unmultiply_row(const uint8_t* src, uint8_t* dst, int width);
+
 }} // namespace caspar::image
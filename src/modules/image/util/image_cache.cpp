@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+
+#include "image_cache.h"
+
+#include <common/env.h>
+#include <common/log.h>
+
+#include <core/frame/pixel_format.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <cstdint>
+#include <ctime>
+#include <future>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace caspar { namespace image {
+
+struct image_cache::impl
+{
+    struct entry
+    {
+        std::wstring                          key;
+        std::time_t                           mtime;
+        std::shared_future<core::const_frame> frame;
+        std::size_t                           size = 0;
+    };
+
+    typedef std::list<entry> lru_t;
+
+    const std::size_t capacity_;
+
+    mutable std::mutex                                mutex_;
+    lru_t                                             lru_; // Most recently used first.
+    std::unordered_map<std::wstring, lru_t::iterator> index_;
+    std::size_t                                       size_      = 0;
+    std::int64_t                                      hits_      = 0;
+    std::int64_t                                      misses_    = 0;
+    std::int64_t                                      evictions_ = 0;
+
+    impl(std::size_t capacity)
+        : capacity_(capacity)
+    {
+    }
+
+    core::const_frame get(const std::wstring& filename, const std::wstring& format, const loader_t& load)
+    {
+        boost::system::error_code ec;
+        auto                      mtime = boost::filesystem::last_write_time(filename, ec);
+
+        // Let the loader report missing files etc.
+        if (capacity_ == 0 || ec) {
+            return load();
+        }
+
+        auto key = filename + L"|" + format;
+
+        std::shared_future<core::const_frame> frame;
+        std::promise<core::const_frame>       promise;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+
+            auto it = index_.find(key);
+            if (it != index_.end() && it->second->mtime == mtime) {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                hits_ += 1;
+                frame = it->second->frame;
+            } else {
+                if (it != index_.end()) {
+                    erase(it->second);
+                }
+
+                misses_ += 1;
+
+                entry e;
+                e.key   = key;
+                e.mtime = mtime;
+                e.frame = promise.get_future().share();
+                lru_.push_front(std::move(e));
+                index_[key] = lru_.begin();
+            }
+        }
+
+        if (frame.valid()) {
+            return frame.get();
+        }
+
+        try {
+            auto result = load();
+            insert(key, mtime, result);
+            promise.set_value(result);
+            return result;
+        } catch (...) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto                        it = index_.find(key);
+                if (it != index_.end() && it->second->mtime == mtime && !it->second->size) {
+                    erase(it->second);
+                }
+            }
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+    }
+
+    void insert(const std::wstring& key, std::time_t mtime, const core::const_frame& frame)
+    {
+        std::size_t size = 0;
+        for (std::size_t n = 0; n < frame.pixel_format_desc().planes.size(); ++n) {
+            size += frame.image_data(n).size();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = index_.find(key);
+        if (it == index_.end() || it->second->mtime != mtime) {
+            return; // Evicted or replaced while loading.
+        }
+
+        it->second->size = size;
+        size_ += size;
+
+        while (size_ > capacity_ && !lru_.empty()) {
+            // An oversized still is evicted right away and simply isn't kept.
+            erase(std::prev(lru_.end()));
+            evictions_ += 1;
+        }
+    }
+
+    void erase(lru_t::iterator it)
+    {
+        size_ -= it->size;
+        index_.erase(it->key);
+        lru_.erase(it);
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        lru_.clear();
+        index_.clear();
+        size_ = 0;
+    }
+
+    core::monitor::state state() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        core::monitor::state state;
+        state["hits"]      = hits_;
+        state["misses"]    = misses_;
+        state["evictions"] = evictions_;
+        state["entries"]   = static_cast<std::int64_t>(lru_.size());
+        state["size"]      = static_cast<std::int64_t>(size_);
+        state["capacity"]  = static_cast<std::int64_t>(capacity_);
+        return state;
+    }
+};
+
+image_cache::image_cache(std::size_t capacity)
+    : impl_(new impl(capacity))
+{
+}
+image_cache::~image_cache() {}
+core::const_frame image_cache::get(const std::wstring& filename, const std::wstring& format, const loader_t& load)
+{
+    return impl_->get(filename, format, load);
+}
+void                 image_cache::clear() { impl_->clear(); }
+core::monitor::state image_cache::state() const { return impl_->state(); }
+
+image_cache& image_cache::instance()
+{
+    static image_cache cache(env::properties().get<std::size_t>(L"configuration.image.cache-size", 256) * 1024 * 1024);
+    return cache;
+}
+
+}} // namespace caspar::image
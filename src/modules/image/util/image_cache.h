@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2011 Sveriges Television AB <info@casparcg.com>
+ *
+ * This file is part of CasparCG (www.casparcg.com).
+ *
+ * CasparCG is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * CasparCG is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with CasparCG. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Robert Nagy, ronag89@gmail.com
+ */
+
+#pragma once
+
+#include <core/frame/frame.h>
+#include <core/monitor/monitor.h>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace caspar { namespace image {
+
+/**
+ * Process wide LRU cache of decoded stills, keyed by file path, modification
+ * time and target format.
+ * <p>
+ * The cached frames have already been committed through a frame factory, so
+ * when the accelerator supports it they also hold on to their uploaded GPU
+ * textures, and a repeated LOAD of the same still skips both decode and upload.
+ */
+class image_cache final
+{
+  public:
+    typedef std::function<core::const_frame()> loader_t;
+
+    explicit image_cache(std::size_t capacity);
+    ~image_cache();
+
+    image_cache(const image_cache&) = delete;
+    image_cache& operator=(const image_cache&) = delete;
+
+    /**
+     * Returns the cached frame for the given file and format, or invokes load
+     * and caches the result. Concurrent requests for the same key share one
+     * load.
+     */
+    core::const_frame get(const std::wstring& filename, const std::wstring& format, const loader_t& load);
+
+    void clear();
+
+    core::monitor::state state() const;
+
+    static image_cache& instance();
+
+  private:
+    struct impl;
+    std::unique_ptr<impl> impl_;
+};
+
+}} // namespace caspar::image
@@ -31,6 +31,10 @@
 #include <common/except.h>
 #include <common/utf.h>
 
+#include <core/frame/frame.h>
+#include <core/frame/frame_factory.h>
+#include <core/frame/pixel_format.h>
+
 #if defined(_MSC_VER)
 #pragma warning(disable : 4714) // marked as __forceinline not inlined
 #endif
@@ -38,12 +42,89 @@
 #include <boost/exception/errinfo_file_name.hpp>
 #include <boost/filesystem.hpp>
 
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
 #include "image_algorithms.h"
-#include "image_view.h"
 
 namespace caspar { namespace image {
 
-std::shared_ptr<FIBITMAP> load_image(const std::wstring& filename)
+int loaded_image::width() const { return static_cast<int>(FreeImage_GetWidth(bitmap.get())); }
+int loaded_image::height() const { return static_cast<int>(FreeImage_GetHeight(bitmap.get())); }
+
+std::shared_ptr<FIBITMAP> load_bitmap(FREE_IMAGE_FORMAT fif, const std::wstring& filename, int flags)
+{
+#ifdef WIN32
+    return std::shared_ptr<FIBITMAP>(FreeImage_LoadU(fif, filename.c_str(), flags), FreeImage_Unload);
+#else
+    return std::shared_ptr<FIBITMAP>(FreeImage_Load(fif, u8(filename).c_str(), flags), FreeImage_Unload);
+#endif
+}
+
+// Smallest size, keeping the aspect ratio, which still covers min_width x min_height.
+std::pair<int, int> cover_size(int width, int height, int min_width, int min_height)
+{
+    if (min_width <= 0 || min_height <= 0 || width <= min_width || height <= min_height) {
+        return std::make_pair(width, height);
+    }
+
+    auto scale = std::max(static_cast<double>(min_width) / width, static_cast<double>(min_height) / height);
+
+    return std::make_pair(std::max(min_width, static_cast<int>(std::ceil(width * scale))),
+                          std::max(min_height, static_cast<int>(std::ceil(height * scale))));
+}
+
+void premultiply_in_place(FIBITMAP* bitmap)
+{
+    auto width  = static_cast<int>(FreeImage_GetWidth(bitmap));
+    auto height = static_cast<int>(FreeImage_GetHeight(bitmap));
+
+    tbb::parallel_for(0, height, [&](int y) {
+        auto row = FreeImage_GetScanLine(bitmap, y);
+        premultiply_row(row, row, width);
+    });
+}
+
+loaded_image to_loaded_image(std::shared_ptr<FIBITMAP> bitmap, bool is_straight_alpha, int min_width, int min_height)
+{
+    if (!bitmap)
+        CASPAR_THROW_EXCEPTION(invalid_argument() << msg_info("Unsupported image format."));
+
+    if (FreeImage_GetBPP(bitmap.get()) != 32) {
+        bitmap = std::shared_ptr<FIBITMAP>(FreeImage_ConvertTo32Bits(bitmap.get()), FreeImage_Unload);
+        if (!bitmap)
+            CASPAR_THROW_EXCEPTION(invalid_argument() << msg_info("Unsupported image format."));
+    }
+
+    auto width  = static_cast<int>(FreeImage_GetWidth(bitmap.get()));
+    auto height = static_cast<int>(FreeImage_GetHeight(bitmap.get()));
+    auto size   = cover_size(width, height, min_width, min_height);
+
+    if (size.first != width || size.second != height) {
+        // Resample premultiplied, otherwise fully transparent pixels bleed their color into the edges.
+        if (is_straight_alpha) {
+            premultiply_in_place(bitmap.get());
+            is_straight_alpha = false;
+        }
+
+        auto scaled = std::shared_ptr<FIBITMAP>(
+            FreeImage_Rescale(bitmap.get(), size.first, size.second, FILTER_BILINEAR), FreeImage_Unload);
+        if (scaled)
+            bitmap = std::move(scaled);
+    }
+
+    loaded_image result;
+    result.bitmap            = std::move(bitmap);
+    result.is_straight_alpha = is_straight_alpha;
+    return result;
+}
+
+FREE_IMAGE_FORMAT image_format(const std::wstring& filename)
 {
     if (!boost::filesystem::exists(filename))
         CASPAR_THROW_EXCEPTION(file_not_found() << boost::errinfo_file_name(u8(filename)));
@@ -64,29 +145,32 @@ std::shared_ptr<FIBITMAP> load_image(const std::wstring& filename)
     if (fif == FIF_UNKNOWN || !FreeImage_FIFSupportsReading(fif))
         CASPAR_THROW_EXCEPTION(invalid_argument() << msg_info("Unsupported image format."));
 
-#ifdef WIN32
-    auto bitmap = std::shared_ptr<FIBITMAP>(FreeImage_LoadU(fif, filename.c_str(), 0), FreeImage_Unload);
-#else
-    auto bitmap = std::shared_ptr<FIBITMAP>(FreeImage_Load(fif, u8(filename).c_str(), 0), FreeImage_Unload);
-#endif
+    return fif;
+}
 
-    if (FreeImage_GetBPP(bitmap.get()) != 32) {
-        bitmap = std::shared_ptr<FIBITMAP>(FreeImage_ConvertTo32Bits(bitmap.get()), FreeImage_Unload);
-        if (!bitmap)
-            CASPAR_THROW_EXCEPTION(invalid_argument() << msg_info("Unsupported image format."));
+loaded_image load_image(const std::wstring& filename, int min_width, int min_height)
+{
+    auto fif = image_format(filename);
+
+    int flags = 0;
+
+    // Let libjpeg skip DCT coefficients instead of decoding at full resolution and throwing the pixels away.
+    if (fif == FIF_JPEG && min_width > 0 && min_height > 0) {
+        auto header = load_bitmap(fif, filename, FIF_LOAD_NOPIXELS);
+        if (header) {
+            auto size = cover_size(static_cast<int>(FreeImage_GetWidth(header.get())),
+                                   static_cast<int>(FreeImage_GetHeight(header.get())),
+                                   min_width,
+                                   min_height);
+            flags |= std::max(size.first, size.second) << 16;
+        }
     }
 
     // PNG-images need to be premultiplied with their alpha
-    if (fif == FIF_PNG) {
-        image_view<bgra_pixel> original_view(
-            FreeImage_GetBits(bitmap.get()), FreeImage_GetWidth(bitmap.get()), FreeImage_GetHeight(bitmap.get()));
-        premultiply(original_view);
-    }
-
-    return bitmap;
+    return to_loaded_image(load_bitmap(fif, filename, flags), fif == FIF_PNG, min_width, min_height);
 }
 
-std::shared_ptr<FIBITMAP> load_png_from_memory(const void* memory_location, size_t size)
+loaded_image load_png_from_memory(const void* memory_location, size_t size)
 {
     FREE_IMAGE_FORMAT fif = FIF_PNG;
 
@@ -95,18 +179,55 @@ std::shared_ptr<FIBITMAP> load_png_from_memory(const void* memory_location, size
         FreeImage_CloseMemory);
     auto bitmap = std::shared_ptr<FIBITMAP>(FreeImage_LoadFromMemory(fif, memory.get(), 0), FreeImage_Unload);
 
-    if (FreeImage_GetBPP(bitmap.get()) != 32) {
-        bitmap = std::shared_ptr<FIBITMAP>(FreeImage_ConvertTo32Bits(bitmap.get()), FreeImage_Unload);
+    return to_loaded_image(std::move(bitmap), true, 0, 0);
+}
 
-        if (!bitmap)
-            CASPAR_THROW_EXCEPTION(invalid_argument() << msg_info("Unsupported image format."));
-    }
+void copy_image(const loaded_image& image, std::uint8_t* dest)
+{
+    auto bitmap = image.bitmap.get();
+    auto width  = image.width();
+    auto height = image.height();
+
+    tbb::parallel_for(0, height, [&](int y) {
+        auto src = FreeImage_GetScanLine(bitmap, height - y - 1);
+        auto dst = dest + static_cast<std::size_t>(y) * width * 4;
+
+        if (image.is_straight_alpha) {
+            premultiply_row(src, dst, width);
+        } else {
+            std::memcpy(dst, src, static_cast<std::size_t>(width) * 4);
+        }
+    });
+}
 
-    // PNG-images need to be premultiplied with their alpha
-    image_view<bgra_pixel> original_view(
-        FreeImage_GetBits(bitmap.get()), FreeImage_GetWidth(bitmap.get()), FreeImage_GetHeight(bitmap.get()));
-    premultiply(original_view);
-    return bitmap;
+core::const_frame create_frame(const spl::shared_ptr<core::frame_factory>& frame_factory,
+                               const void*                                 tag,
+                               const loaded_image&                         image)
+{
+    core::pixel_format_desc desc;
+    desc.format = core::pixel_format::bgra;
+    desc.planes.push_back(core::pixel_format_desc::plane(image.width(), image.height(), 4));
+    auto frame = frame_factory->create_frame(tag, desc);
+
+    copy_image(image, frame.image_data(0).data());
+    return core::const_frame(std::move(frame));
+}
+
+executor& decode_executor()
+{
+    static std::vector<std::unique_ptr<executor>> executors = [] {
+        auto count = std::max(2u, std::min(8u, std::thread::hardware_concurrency() / 2));
+
+        std::vector<std::unique_ptr<executor>> result;
+        for (unsigned n = 0; n < count; ++n) {
+            result.push_back(std::make_unique<executor>(L"image decode " + std::to_wstring(n)));
+        }
+        return result;
+    }();
+
+    return **std::min_element(executors.begin(), executors.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs->size() < rhs->size();
+    });
 }
 
 const std::set<std::wstring>& supported_extensions()
@@ -21,6 +21,12 @@
 
 #pragma once
 
+#include <common/executor.h>
+#include <common/memory.h>
+
+#include <core/fwd.h>
+
+#include <cstdint>
 #include <memory>
 #include <set>
 #include <string>
@@ -29,8 +35,46 @@ struct FIBITMAP;
 
 namespace caspar { namespace image {
 
-std::shared_ptr<FIBITMAP>     load_image(const std::wstring& filename);
-std::shared_ptr<FIBITMAP>     load_png_from_memory(const void* memory_location, size_t size);
+/**
+ * A decoded 32 bit bitmap, still stored bottom-up the way FreeImage keeps it.
+ * Straight alpha images are premultiplied by copy_image.
+ */
+struct loaded_image
+{
+    std::shared_ptr<FIBITMAP> bitmap;
+    bool                      is_straight_alpha = false;
+
+    int width() const;
+    int height() const;
+};
+
+/**
+ * Decodes an image file. If min_width and min_height are given, images larger
+ * than that in both dimensions are decoded (DCT scaled for JPEG) and resized to
+ * the smallest size, keeping the aspect ratio, which still covers
+ * min_width x min_height.
+ */
+loaded_image load_image(const std::wstring& filename, int min_width = 0, int min_height = 0);
+loaded_image load_png_from_memory(const void* memory_location, size_t size);
+
+/**
+ * Copies the image top-down into a tightly packed BGRA buffer, premultiplying
+ * straight alpha on the way, in a single pass.
+ */
+void copy_image(const loaded_image& image, std::uint8_t* dest);
+
+/**
+ * Uploads a decoded image into a new BGRA frame.
+ */
+core::const_frame create_frame(const spl::shared_ptr<core::frame_factory>& frame_factory,
+                               const void*                                 tag,
+                               const loaded_image&                         image);
+
+/**
+ * Returns the least busy of the shared image decode threads.
+ */
+executor& decode_executor();
+
 const std::set<std::wstring>& supported_extensions();
 
 }} // namespace caspar::image
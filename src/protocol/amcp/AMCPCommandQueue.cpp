@@ -25,6 +25,7 @@
 
 #include <boost/lexical_cast.hpp>
 #include <common/except.h>
+#include <core/destroyer.h>
 
 #include <cmath>
 
@@ -85,6 +86,9 @@ void AMCPCommandQueue::AddCommand(AMCPCommand::ptr_type pCurrentCommand)
             try {
                 caspar::timer timer;
 
+                // Commands may wait for the destroyer to catch up, unlike the channels.
+                core::destroyer::scoped_wait destroyer_wait;
+
                 auto print  = pCurrentCommand->print();
                 auto params = boost::join(pCurrentCommand->parameters(), L" ");
 
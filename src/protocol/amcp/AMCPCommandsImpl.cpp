@@ -44,12 +44,14 @@
 #include <core/diagnostics/osd_graph.h>
 #include <core/frame/frame_transform.h>
 #include <core/mixer/mixer.h>
+#include <core/monitor/system_state.h>
 #include <core/producer/cg_proxy.h>
 #include <core/producer/frame_producer.h>
 #include <core/producer/layer.h>
 #include <core/producer/stage.h>
 #include <core/producer/transition/sting_producer.h>
 #include <core/producer/transition/transition_producer.h>
+#include <core/snapshot.h>
 #include <core/video_format.h>
 
 #include <algorithm>
@@ -211,11 +213,13 @@ std::vector<spl::shared_ptr<core::video_channel>> get_channels(const command_con
 core::frame_producer_dependencies get_producer_dependencies(const std::shared_ptr<core::video_channel>& channel,
                                                             const command_context&                      ctx)
 {
-    return core::frame_producer_dependencies(channel->frame_factory(),
-                                             get_channels(ctx),
-                                             channel->video_format_desc(),
-                                             ctx.producer_registry,
-                                             ctx.cg_registry);
+    core::frame_producer_dependencies dependencies(channel->frame_factory(),
+                                                   get_channels(ctx),
+                                                   channel->video_format_desc(),
+                                                   ctx.producer_registry,
+                                                   ctx.cg_registry);
+    dependencies.offline = channel->offline_flag();
+    return dependencies;
 }
 
 // Basic Commands
@@ -251,7 +255,7 @@ std::wstring loadbg_command(command_context& ctx)
         transition_producer = create_transition_producer(pFP, transitionInfo);
     }
 
-    channel->stage().load(ctx.layer_index(), transition_producer, false, auto_play); // TODO: LOOP
+    channel->stage().load(ctx.layer_index(), transition_producer, false, auto_play, ctx.parameters); // TODO: LOOP
 
     return L"202 LOADBG OK\r\n";
 }
@@ -265,7 +269,7 @@ std::wstring load_command(command_context& ctx)
         ctx.producer_registry->create_producer(get_producer_dependencies(ctx.channel.channel, ctx), ctx.parameters);
     auto pFP2 = create_transition_producer(pFP, transition_info{});
 
-    ctx.channel.channel->stage().load(ctx.layer_index(), pFP2, true);
+    ctx.channel.channel->stage().load(ctx.layer_index(), pFP2, true, false, ctx.parameters);
 
     return L"202 LOAD OK\r\n";
 }
@@ -424,6 +428,17 @@ std::wstring set_command(command_context& ctx)
         CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Invalid video mode"));
     }
 
+    if (name == L"OFFLINE") {
+        if (value == L"1" || value == L"ON" || value == L"TRUE") {
+            ctx.channel.channel->offline(true);
+        } else if (value == L"0" || value == L"OFF" || value == L"FALSE") {
+            ctx.channel.channel->offline(false);
+        } else {
+            CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Invalid offline value"));
+        }
+        return L"202 SET OFFLINE OK\r\n";
+    }
+
     CASPAR_THROW_EXCEPTION(user_error() << msg_info(L"Invalid channel variable"));
 }
 
@@ -1331,28 +1346,32 @@ struct param_visitor : public boost::static_visitor<void>
     void operator()(const std::wstring& value) { o.add(path, value); }
 };
 
-std::wstring info_channel_command(command_context& ctx)
+pt::wptree state_to_ptree(const core::monitor::state& state)
 {
-    std::wstringstream replyString;
-    // This is needed for backwards compatibility with old clients
-    replyString << L"201 INFO OK\r\n";
-
-    pt::wptree info;
-    pt::wptree channel_info;
+    pt::wptree result;
 
-    auto state = ctx.channel.channel->state();
     for (const auto& p : state) {
         const auto replaced = boost::algorithm::replace_all_copy(p.first, "/", ".");
         // avoid digit-only nodes in XML
         const auto path = boost::algorithm::replace_all_regex_copy(
             replaced, boost::regex("\\.(.*?)\\.([0-9]*?)\\."), std::string(".$1.$1_$2."));
-        param_visitor param_visitor(path, channel_info);
+        param_visitor param_visitor(path, result);
         for (const auto& element : p.second) {
             boost::apply_visitor(param_visitor, element);
         }
     }
 
-    info.add_child(L"channel", channel_info);
+    return result;
+}
+
+std::wstring info_channel_command(command_context& ctx)
+{
+    std::wstringstream replyString;
+    // This is needed for backwards compatibility with old clients
+    replyString << L"201 INFO OK\r\n";
+
+    pt::wptree info;
+    info.add_child(L"channel", state_to_ptree(ctx.channel.channel->state()));
 
     pt::xml_writer_settings<std::wstring> w(' ', 3);
     pt::xml_parser::write_xml(replyString, info, w);
@@ -1374,6 +1393,37 @@ std::wstring info_command(command_context& ctx)
     return replyString.str();
 }
 
+std::wstring info_system_command(command_context& ctx)
+{
+    std::wstringstream replyString;
+    replyString << L"201 INFO SYSTEM OK\r\n";
+
+    pt::wptree info;
+    info.add_child(L"system", state_to_ptree(core::monitor::system_state()));
+
+    pt::xml_writer_settings<std::wstring> w(' ', 3);
+    pt::xml_parser::write_xml(replyString, info, w);
+
+    replyString << L"\r\n";
+    return replyString.str();
+}
+
+std::wstring snapshot_save_command(command_context& ctx)
+{
+    auto path = ctx.parameters.empty() ? core::snapshot_path() : env::data_folder() + ctx.parameters.at(0);
+    core::save_snapshot(get_channels(ctx), path);
+    return L"202 SNAPSHOT SAVE OK\r\n";
+}
+
+std::wstring snapshot_restore_command(command_context& ctx)
+{
+    auto path        = ctx.parameters.empty() ? core::snapshot_path() : env::data_folder() + ctx.parameters.at(0);
+    auto time_to_air = core::restore_snapshot(path, get_channels(ctx), ctx.producer_registry, ctx.cg_registry);
+
+    return L"201 SNAPSHOT RESTORE OK\r\n" + boost::lexical_cast<std::wstring>(static_cast<int>(time_to_air * 1000)) +
+           L"\r\n";
+}
+
 std::wstring diag_command(command_context& ctx)
 {
     core::diagnostics::osd::show_graphs(true);
@@ -1454,6 +1504,8 @@ void register_commands(amcp_command_repository& repo)
     repo.register_command(L"Basic Commands", L"LOG LEVEL", log_level_command, 0);
     repo.register_channel_command(L"Basic Commands", L"SET", set_command, 2);
     repo.register_command(L"Basic Commands", L"LOCK", lock_command, 2);
+    repo.register_command(L"Basic Commands", L"SNAPSHOT SAVE", snapshot_save_command, 0);
+    repo.register_command(L"Basic Commands", L"SNAPSHOT RESTORE", snapshot_restore_command, 0);
 
     repo.register_command(L"Data Commands", L"DATA STORE", data_store_command, 2);
     repo.register_command(L"Data Commands", L"DATA RETRIEVE", data_retrieve_command, 1);
@@ -1507,6 +1559,7 @@ void register_commands(amcp_command_repository& repo)
     repo.register_command(L"Query Commands", L"RESTART", restart_command, 0);
     repo.register_channel_command(L"Query Commands", L"INFO", info_channel_command, 0);
     repo.register_command(L"Query Commands", L"INFO", info_command, 0);
+    repo.register_command(L"Query Commands", L"INFO SYSTEM", info_system_command, 0);
 }
 
 }}} // namespace caspar::protocol::amcp
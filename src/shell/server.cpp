@@ -25,6 +25,7 @@
 
 #include <common/env.h>
 #include <common/except.h>
+#include <common/log.h>
 #include <common/memory.h>
 #include <common/ptree.h>
 #include <common/utf.h>
@@ -32,12 +33,14 @@
 #include <core/consumer/output.h>
 #include <core/diagnostics/call_context.h>
 #include <core/diagnostics/osd_graph.h>
+#include <core/monitor/system_state.h>
 #include <core/mixer/image/image_mixer.h>
 #include <core/mixer/mixer.h>
 #include <core/producer/cg_proxy.h>
 #include <core/producer/color/color_producer.h>
 #include <core/producer/frame_producer.h>
 #include <core/producer/stage.h>
+#include <core/snapshot.h>
 #include <core/video_channel.h>
 #include <core/video_format.h>
 
@@ -54,11 +57,16 @@
 
 #include <boost/algorithm/string.hpp>
 #include <boost/asio.hpp>
+#include <boost/filesystem.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
 
+#include <algorithm>
+#include <chrono>
 #include <future>
+#include <map>
+#include <mutex>
 #include <thread>
 
 namespace caspar {
@@ -96,20 +104,116 @@ std::shared_ptr<boost::asio::io_service> create_running_io_service()
     });
 }
 
+// Records how long each step of bringing the server up took, relative to when the server was created.
+class startup_timeline
+{
+    typedef std::chrono::steady_clock clock_t;
+
+    struct step
+    {
+        std::wstring name;
+        double       start;
+        double       duration;
+        bool         failed;
+    };
+
+    const clock_t::time_point start_ = clock_t::now();
+    mutable std::mutex        mutex_;
+    std::vector<step>         steps_;
+    double                    total_ = 0.0;
+
+  public:
+    template <typename Func>
+    void measure(const std::wstring& name, Func&& func)
+    {
+        auto begin = clock_t::now();
+        try {
+            func();
+        } catch (...) {
+            record(name, begin, true);
+            throw;
+        }
+        record(name, begin, false);
+    }
+
+    void finish()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        total_ = seconds(clock_t::now() - start_);
+        std::stable_sort(steps_.begin(), steps_.end(), [](const step& a, const step& b) { return a.start < b.start; });
+
+        CASPAR_LOG(info) << L"Startup completed in " << static_cast<int>(total_ * 1000) << L" ms:";
+        for (auto& step : steps_) {
+            CASPAR_LOG(info) << L"  " << step.name << L": +" << static_cast<int>(step.start * 1000) << L" ms, took "
+                             << static_cast<int>(step.duration * 1000) << L" ms" << (step.failed ? L" (failed)" : L"");
+        }
+    }
+
+    monitor::state state() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        monitor::state state;
+        state["total"] = total_;
+        for (auto& step : steps_) {
+            auto name                            = u8(step.name);
+            state["steps/" + name + "/start"]    = step.start;
+            state["steps/" + name + "/duration"] = step.duration;
+            state["steps/" + name + "/failed"]   = step.failed;
+        }
+        return state;
+    }
+
+  private:
+    void record(const std::wstring& name, clock_t::time_point begin, bool failed)
+    {
+        auto end = clock_t::now();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        steps_.push_back(step{name, seconds(begin - start_), seconds(end - begin), failed});
+    }
+
+    static double seconds(clock_t::duration duration)
+    {
+        return std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+    }
+};
+
+// A consumer created from the configuration, remembered so that a reload can tell whether it changed.
+struct configured_consumer
+{
+    std::wstring                 name;
+    boost::property_tree::wptree xml;
+    int                          index;
+};
+
+// A tcp controller, keyed by protocol and port.
+struct configured_controller
+{
+    std::wstring                          key;
+    spl::shared_ptr<IO::AsyncEventServer> server;
+};
+
 struct server::impl : boost::noncopyable
 {
-    std::shared_ptr<boost::asio::io_service>           io_service_ = create_running_io_service();
-    accelerator::accelerator                           accelerator_;
-    std::shared_ptr<amcp::amcp_command_repository>     amcp_command_repo_;
-    std::vector<spl::shared_ptr<IO::AsyncEventServer>> async_servers_;
-    std::shared_ptr<IO::AsyncEventServer>              primary_amcp_server_;
-    std::shared_ptr<osc::client>                       osc_client_ = std::make_shared<osc::client>(io_service_);
-    std::vector<std::shared_ptr<void>>                 predefined_osc_subscriptions_;
-    std::vector<spl::shared_ptr<video_channel>>        channels_;
-    spl::shared_ptr<core::cg_producer_registry>        cg_registry_;
-    spl::shared_ptr<core::frame_producer_registry>     producer_registry_;
-    spl::shared_ptr<core::frame_consumer_registry>     consumer_registry_;
-    std::function<void(bool)>                          shutdown_server_now_;
+    std::shared_ptr<startup_timeline>              timeline_   = std::make_shared<startup_timeline>();
+    std::shared_ptr<boost::asio::io_service>       io_service_ = create_running_io_service();
+    accelerator::accelerator                       accelerator_;
+    std::shared_ptr<amcp::amcp_command_repository> amcp_command_repo_;
+    std::vector<configured_controller>             async_servers_;
+    std::shared_ptr<IO::AsyncEventServer>          primary_amcp_server_;
+    std::shared_ptr<osc::client>                   osc_client_ = std::make_shared<osc::client>(io_service_);
+    std::map<std::wstring, std::shared_ptr<void>>  predefined_osc_subscriptions_;
+    std::vector<spl::shared_ptr<video_channel>>    channels_;
+    std::vector<std::vector<configured_consumer>>  configured_consumers_;
+    spl::shared_ptr<core::cg_producer_registry>    cg_registry_;
+    spl::shared_ptr<core::frame_producer_registry> producer_registry_;
+    spl::shared_ptr<core::frame_consumer_registry> consumer_registry_;
+    std::function<void(bool)>                      shutdown_server_now_;
+    std::unique_ptr<core::snapshot_writer>         snapshot_writer_;
+    boost::property_tree::wptree                   config_;
+    std::mutex                                     reload_mutex_;
 
     explicit impl(std::function<void(bool)> shutdown_server_now)
         : accelerator_(env::properties().get(L"configuration.accelerator", L"auto"))
@@ -117,28 +221,46 @@ struct server::impl : boost::noncopyable
         , consumer_registry_(spl::make_shared<core::frame_consumer_registry>())
         , shutdown_server_now_(shutdown_server_now)
     {
+        std::weak_ptr<startup_timeline> weak_timeline = timeline_;
+        core::monitor::register_system_state("startup", [weak_timeline] {
+            auto timeline = weak_timeline.lock();
+            return timeline ? timeline->state() : core::monitor::state();
+        });
+        core::monitor::register_system_state("snapshot", core::snapshot_state);
+
         caspar::core::diagnostics::osd::register_sink();
 
         module_dependencies dependencies(cg_registry_, producer_registry_, consumer_registry_);
 
-        initialize_modules(dependencies);
+        initialize_modules(dependencies,
+                           [this](const std::wstring& name, const std::function<void()>& init) {
+                               timeline_->measure(name, init);
+                           });
         core::init_cg_proxy_as_producer(dependencies);
     }
 
     void start()
     {
+        config_ = env::properties();
+
         setup_channels(env::properties());
         CASPAR_LOG(info) << L"Initialized channels.";
 
-        setup_controllers(env::properties());
+        setup_snapshots(env::properties());
+
+        timeline_->measure(L"controllers", [&] { setup_controllers(env::properties()); });
         CASPAR_LOG(info) << L"Initialized controllers.";
 
-        setup_osc(env::properties());
+        timeline_->measure(L"osc", [&] { setup_osc(env::properties()); });
         CASPAR_LOG(info) << L"Initialized osc.";
+
+        timeline_->finish();
     }
 
     ~impl()
     {
+        snapshot_writer_.reset();
+
         std::weak_ptr<boost::asio::io_service> weak_io_service = io_service_;
         io_service_.reset();
         osc_client_.reset();
@@ -173,41 +295,98 @@ struct server::impl : boost::noncopyable
 
             auto weak_client = std::weak_ptr<osc::client>(osc_client_);
             auto channel_id  = static_cast<int>(channels_.size() + 1);
-            auto channel =
-                spl::make_shared<video_channel>(channel_id,
-                                                format_desc,
-                                                accelerator_.create_image_mixer(channel_id),
-                                                [channel_id, weak_client](core::monitor::state channel_state) {
-                                                    monitor::state state;
-                                                    state[""]["channel"][channel_id] = channel_state;
-                                                    auto client                      = weak_client.lock();
-                                                    if (client) {
-                                                        client->send(std::move(state));
-                                                    }
-                                                });
-
-            channels_.push_back(channel);
+
+            // The accelerator is not thread-safe, so channels themselves are created one at a time.
+            timeline_->measure(L"channel/" + std::to_wstring(channel_id), [&] {
+                channels_.push_back(spl::make_shared<video_channel>(
+                    channel_id,
+                    format_desc,
+                    accelerator_.create_image_mixer(channel_id),
+                    [channel_id, weak_client](core::monitor::state channel_state) {
+                        monitor::state state;
+                        state[""]["channel"][channel_id] = channel_state;
+                        auto client                      = weak_client.lock();
+                        if (client) {
+                            client->send(std::move(state));
+                        }
+                    }));
+            });
+
+            configure_channel(channels_.back(), xml_channel.second);
         }
 
+        // Consumers (decklink, screen, ffmpeg, ...) can take seconds each to open, so every channel brings up its own
+        // consumers concurrently. Within a channel they are still added in configuration order.
+        std::vector<std::future<void>> consumers;
+
+        configured_consumers_.resize(channels_.size());
+
         for (auto& channel : channels_) {
-            core::diagnostics::scoped_call_context save;
-            core::diagnostics::call_context::for_thread().video_channel = channel->index();
+            auto xml_channel = xml_channels.at(channel->index() - 1);
+
+            if (!xml_channel.get_child_optional(L"consumers"))
+                continue;
+
+            consumers.push_back(std::async(std::launch::async, [=] {
+                timeline_->measure(L"channel/" + std::to_wstring(channel->index()) + L"/consumers", [&] {
+                    core::diagnostics::scoped_call_context save;
+                    core::diagnostics::call_context::for_thread().video_channel = channel->index();
 
-            if (xml_channels.at(channel->index() - 1).get_child_optional(L"consumers")) {
-                for (auto& xml_consumer : xml_channels.at(channel->index() - 1) | witerate_children(L"consumers") |
-                                              welement_context_iteration) {
-                    auto name = xml_consumer.first;
-
-                    try {
-                        if (name != L"<xmlcomment>")
-                            channel->output().add(
-                                consumer_registry_->create_consumer(name, xml_consumer.second, channels_));
-                    } catch (...) {
-                        CASPAR_LOG_CURRENT_EXCEPTION();
+                    for (auto& xml_consumer :
+                         xml_channel | witerate_children(L"consumers") | welement_context_iteration) {
+                        if (xml_consumer.first != L"<xmlcomment>")
+                            add_consumer(channel, xml_consumer.first, xml_consumer.second);
                     }
+                });
+            }));
+        }
+
+        for (auto& consumer : consumers) {
+            consumer.get();
+        }
+    }
+
+    // Settings which can be changed while the channel is running.
+    static void configure_channel(const spl::shared_ptr<video_channel>&  channel,
+                                  const boost::property_tree::wptree& xml)
+    {
+        channel->output().genlock(xml.get(L"genlock", false), std::chrono::microseconds(xml.get(L"genlock-phase", 0)));
+        channel->mixer().set_readback_depth(xml.get(L"readback-depth", 1));
+        channel->offline(xml.get(L"offline", false));
+    }
+
+    // Only called from the thread which owns the configured consumers of the channel.
+    void add_consumer(const spl::shared_ptr<video_channel>&  channel,
+                      const std::wstring&                  name,
+                      const boost::property_tree::wptree& xml)
+    {
+        try {
+            auto consumer = consumer_registry_->create_consumer(name, xml, channels_);
+            auto index    = consumer->index();
+            channel->output().add(consumer);
+            configured_consumers_.at(channel->index() - 1).push_back(configured_consumer{name, xml, index});
+        } catch (...) {
+            CASPAR_LOG_CURRENT_EXCEPTION();
+        }
+    }
+
+    void setup_snapshots(const boost::property_tree::wptree& pt)
+    {
+        auto path = core::snapshot_path();
+
+        if (pt.get(L"configuration.snapshot.restore", false) && boost::filesystem::exists(path)) {
+            timeline_->measure(L"snapshot", [&] {
+                try {
+                    core::restore_snapshot(path, channels_, producer_registry_, cg_registry_);
+                } catch (...) {
+                    CASPAR_LOG_CURRENT_EXCEPTION();
                 }
-            }
+            });
         }
+
+        auto interval = pt.get(L"configuration.snapshot.interval", 0);
+        if (interval > 0)
+            snapshot_writer_.reset(new core::snapshot_writer(channels_, path, interval));
     }
 
     void setup_osc(const boost::property_tree::wptree& pt)
@@ -227,13 +406,7 @@ struct server::impl : boost::noncopyable
                 const auto address = ptree_get<std::wstring>(predefined_client.second, L"address");
                 const auto port    = ptree_get<unsigned short>(predefined_client.second, L"port");
 
-                boost::system::error_code ec;
-                auto                      ipaddr = address_v4::from_string(u8(address), ec);
-                if (!ec)
-                    predefined_osc_subscriptions_.push_back(
-                        osc_client_->get_subscription_token(udp::endpoint(ipaddr, port)));
-                else
-                    CASPAR_LOG(warning) << "Invalid OSC client. Must be valid ipv4 address: " << address;
+                add_osc_client(address, port);
             }
         }
 
@@ -248,32 +421,240 @@ struct server::impl : boost::noncopyable
                 });
     }
 
+    void add_osc_client(const std::wstring& address, unsigned short port)
+    {
+        using namespace boost::asio::ip;
+
+        boost::system::error_code ec;
+        auto                      ipaddr = address_v4::from_string(u8(address), ec);
+        if (!ec)
+            predefined_osc_subscriptions_[osc_client_key(address, port)] =
+                osc_client_->get_subscription_token(udp::endpoint(ipaddr, port));
+        else
+            CASPAR_LOG(warning) << "Invalid OSC client. Must be valid ipv4 address: " << address;
+    }
+
+    static std::wstring osc_client_key(const std::wstring& address, unsigned short port)
+    {
+        return address + L":" + boost::lexical_cast<std::wstring>(port);
+    }
+
     void setup_controllers(const boost::property_tree::wptree& pt)
     {
         amcp_command_repo_ = spl::make_shared<amcp::amcp_command_repository>(
             channels_, cg_registry_, producer_registry_, consumer_registry_, shutdown_server_now_);
         amcp::register_commands(*amcp_command_repo_);
 
+        amcp_command_repo_->register_command(
+            L"Query Commands", L"RELOAD", [this](amcp::command_context&) { return reload_command(); }, 0);
+
         using boost::property_tree::wptree;
         for (auto& xml_controller : pt | witerate_children(L"configuration.controllers") | welement_context_iteration) {
-            auto name     = xml_controller.first;
-            auto protocol = ptree_get<std::wstring>(xml_controller.second, L"protocol");
-
-            if (name == L"tcp") {
-                auto port              = ptree_get<unsigned int>(xml_controller.second, L"port");
-                auto asyncbootstrapper = spl::make_shared<IO::AsyncEventServer>(
-                    io_service_,
-                    create_protocol(protocol, L"TCP Port " + boost::lexical_cast<std::wstring>(port)),
-                    static_cast<short>(port));
-                async_servers_.push_back(asyncbootstrapper);
-
-                if (!primary_amcp_server_ && boost::iequals(protocol, L"AMCP"))
-                    primary_amcp_server_ = asyncbootstrapper;
-            } else
+            auto name = xml_controller.first;
+
+            if (name == L"tcp")
+                add_controller(xml_controller.second);
+            else
                 CASPAR_LOG(warning) << "Invalid controller: " << name;
         }
     }
 
+    void add_controller(const boost::property_tree::wptree& xml)
+    {
+        auto protocol          = ptree_get<std::wstring>(xml, L"protocol");
+        auto port              = ptree_get<unsigned int>(xml, L"port");
+        auto asyncbootstrapper = spl::make_shared<IO::AsyncEventServer>(
+            io_service_,
+            create_protocol(protocol, L"TCP Port " + boost::lexical_cast<std::wstring>(port)),
+            static_cast<short>(port));
+        async_servers_.push_back(configured_controller{controller_key(xml), asyncbootstrapper});
+
+        if (!primary_amcp_server_ && boost::iequals(protocol, L"AMCP"))
+            primary_amcp_server_ = asyncbootstrapper;
+    }
+
+    static std::wstring controller_key(const boost::property_tree::wptree& xml)
+    {
+        return boost::to_upper_copy(ptree_get<std::wstring>(xml, L"protocol")) + L":" +
+               boost::lexical_cast<std::wstring>(ptree_get<unsigned int>(xml, L"port"));
+    }
+
+    std::wstring reload_command()
+    {
+        try {
+            reload(env::reload());
+        } catch (...) {
+            CASPAR_LOG_CURRENT_EXCEPTION();
+            return L"501 RELOAD FAILED\r\n";
+        }
+        return L"202 RELOAD OK\r\n";
+    }
+
+    // Applies the differences between the running configuration and pt. Channels whose settings did not change are
+    // left alone, so they keep playing without so much as a dropped frame.
+    void reload(const boost::property_tree::wptree& pt)
+    {
+        std::lock_guard<std::mutex> lock(reload_mutex_);
+
+        CASPAR_LOG(info) << L"Reloading configuration.";
+
+        auto log_level = pt.get(L"configuration.log-level", L"info");
+        if (log_level != config_.get(L"configuration.log-level", L"info") && !log::set_log_level(log_level))
+            CASPAR_LOG(warning) << L"Invalid log-level: " << log_level;
+
+        reload_channels(pt);
+        reload_controllers(pt);
+        reload_osc(pt);
+
+        config_ = pt;
+
+        CASPAR_LOG(info) << L"Reloaded configuration. Other settings apply to producers and consumers created from now "
+                            L"on.";
+    }
+
+    void reload_channels(const boost::property_tree::wptree& pt)
+    {
+        std::vector<boost::property_tree::wptree> xml_channels;
+        for (auto& xml_channel : pt | witerate_children(L"configuration.channels") | welement_context_iteration) {
+            ptree_verify_element_name(xml_channel, L"channel");
+            xml_channels.push_back(xml_channel.second);
+        }
+
+        if (xml_channels.size() != channels_.size())
+            CASPAR_LOG(warning) << L"Adding or removing channels requires a restart. Only the first "
+                                << std::min(xml_channels.size(), channels_.size()) << L" channels are reloaded.";
+
+        for (std::size_t n = 0; n < std::min(xml_channels.size(), channels_.size()); ++n) {
+            auto& channel     = channels_.at(n);
+            auto& xml_channel = xml_channels.at(n);
+
+            core::diagnostics::scoped_call_context save;
+            core::diagnostics::call_context::for_thread().video_channel = channel->index();
+
+            auto format_desc_str = xml_channel.get(L"video-mode", L"PAL");
+            auto format_desc     = video_format_desc(format_desc_str);
+            if (format_desc.format == video_format::invalid)
+                CASPAR_LOG(warning) << L"Invalid video-mode: " << format_desc_str;
+            else if (format_desc.format != channel->video_format_desc().format) {
+                CASPAR_LOG(info) << L"video_channel[" << channel->index() << L"] Changing video-mode to "
+                                 << format_desc.name << L".";
+                channel->video_format_desc(format_desc);
+            }
+
+            configure_channel(channel, xml_channel);
+            reload_consumers(channel, xml_channel);
+        }
+    }
+
+    void reload_consumers(const spl::shared_ptr<video_channel>& channel, const boost::property_tree::wptree& xml)
+    {
+        typedef std::pair<std::wstring, boost::property_tree::wptree> consumer_xml_t;
+
+        std::vector<consumer_xml_t> added;
+        if (xml.get_child_optional(L"consumers")) {
+            for (auto& xml_consumer : xml | witerate_children(L"consumers") | welement_context_iteration) {
+                if (xml_consumer.first != L"<xmlcomment>")
+                    added.emplace_back(xml_consumer.first, xml_consumer.second);
+            }
+        }
+
+        // Consumers with an identical configuration keep running, everything else is removed before anything is
+        // added, so that a consumer given new settings gets its device back.
+        auto&                            configured = configured_consumers_.at(channel->index() - 1);
+        std::vector<configured_consumer> kept;
+
+        for (auto& consumer : configured) {
+            auto it = std::find_if(added.begin(), added.end(), [&](const consumer_xml_t& x) {
+                return x.first == consumer.name && x.second == consumer.xml;
+            });
+
+            if (it != added.end()) {
+                kept.push_back(consumer);
+                added.erase(it);
+            } else {
+                CASPAR_LOG(info) << L"video_channel[" << channel->index() << L"] Removing " << consumer.name
+                                 << L" consumer.";
+                channel->output().remove(consumer.index);
+            }
+        }
+
+        configured = std::move(kept);
+
+        for (auto& consumer : added) {
+            CASPAR_LOG(info) << L"video_channel[" << channel->index() << L"] Adding " << consumer.first
+                             << L" consumer.";
+            add_consumer(channel, consumer.first, consumer.second);
+        }
+    }
+
+    void reload_controllers(const boost::property_tree::wptree& pt)
+    {
+        std::vector<boost::property_tree::wptree> added;
+        for (auto& xml_controller : pt | witerate_children(L"configuration.controllers") | welement_context_iteration) {
+            if (xml_controller.first == L"tcp")
+                added.push_back(xml_controller.second);
+        }
+
+        std::vector<configured_controller> kept;
+
+        for (auto& controller : async_servers_) {
+            auto it = std::find_if(added.begin(), added.end(), [&](const boost::property_tree::wptree& x) {
+                return controller_key(x) == controller.key;
+            });
+
+            if (it != added.end()) {
+                kept.push_back(controller);
+                added.erase(it);
+            } else if (controller.server == primary_amcp_server_) {
+                CASPAR_LOG(warning) << L"Removing the first AMCP controller (" << controller.key
+                                    << L") requires a restart.";
+                kept.push_back(controller);
+            } else {
+                CASPAR_LOG(info) << L"Removing controller " << controller.key << L".";
+            }
+        }
+
+        // Closes the acceptors of removed controllers before their ports may be taken by new ones.
+        async_servers_ = std::move(kept);
+
+        for (auto& xml_controller : added) {
+            try {
+                CASPAR_LOG(info) << L"Adding controller " << controller_key(xml_controller) << L".";
+                add_controller(xml_controller);
+            } catch (...) {
+                CASPAR_LOG_CURRENT_EXCEPTION();
+            }
+        }
+    }
+
+    void reload_osc(const boost::property_tree::wptree& pt)
+    {
+        std::map<std::wstring, std::pair<std::wstring, unsigned short>> clients;
+        if (pt.get_child_optional(L"configuration.osc.predefined-clients")) {
+            for (auto& predefined_client :
+                 pt | witerate_children(L"configuration.osc.predefined-clients") | welement_context_iteration) {
+                ptree_verify_element_name(predefined_client, L"predefined-client");
+
+                const auto address = ptree_get<std::wstring>(predefined_client.second, L"address");
+                const auto port    = ptree_get<unsigned short>(predefined_client.second, L"port");
+                clients[osc_client_key(address, port)] = std::make_pair(address, port);
+            }
+        }
+
+        for (auto it = predefined_osc_subscriptions_.begin(); it != predefined_osc_subscriptions_.end();) {
+            if (clients.erase(it->first) == 0) {
+                CASPAR_LOG(info) << L"Removing OSC client " << it->first << L".";
+                it = predefined_osc_subscriptions_.erase(it);
+            } else
+                ++it;
+        }
+
+        for (auto& client : clients) {
+            CASPAR_LOG(info) << L"Adding OSC client " << client.first << L".";
+            add_osc_client(client.second.first, client.second.second);
+        }
+    }
+
     IO::protocol_strategy_factory<char>::ptr create_protocol(const std::wstring& name,
                                                              const std::wstring& port_description) const
     {